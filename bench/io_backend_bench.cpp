@@ -0,0 +1,189 @@
+// Closed-loop keep-alive benchmark: runs the same in-process server on each I/O
+// backend and drives it with N client connections for a fixed time.
+//
+//   io_backend_bench [--connections=64] [--seconds=5] [--server-threads=2] [--body=64]
+
+#include "http_server.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+struct BenchOptions {
+    int connections = 64;
+    int seconds = 5;
+    int serverThreads = 2;
+    size_t bodySize = 64;
+};
+
+struct BenchResult {
+    uint64_t requests = 0;
+    double seconds = 0;
+    double p50Us = 0;
+    double p99Us = 0;
+};
+
+int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Reads exactly one response; returns false when the connection broke.
+bool readResponse(int fd, ::std::string& buffer) {
+    size_t headerEnd = ::std::string::npos;
+    size_t total = 0;
+    char chunk[16384];
+    while (true) {
+        if (headerEnd == ::std::string::npos) {
+            headerEnd = buffer.find("\r\n\r\n");
+            if (headerEnd != ::std::string::npos) {
+                size_t pos = buffer.find("Content-Length: ");
+                size_t length = pos < headerEnd ? ::std::strtoul(buffer.c_str() + pos + 16, nullptr, 10) : 0;
+                total = headerEnd + 4 + length;
+            }
+        }
+        if (headerEnd != ::std::string::npos && buffer.size() >= total) {
+            buffer.erase(0, total);
+            return true;
+        }
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer.append(chunk, received);
+    }
+}
+
+BenchResult runBackend(SimpleHttp::IoModel model, int port, const BenchOptions& options) {
+    SimpleHttp::ServerConfig config;
+    config.ioModel = model;
+    config.eventLoopThreads = options.serverThreads;
+    config.maxRequestsPerConnection = 1 << 30;
+    config.compressionLevel = 0;
+
+    SimpleHttp::Server server(port, config);
+    ::std::string body(options.bodySize, 'x');
+    ::std::thread serverThread([&]() {
+        server.start([&](const SimpleHttp::Request&) {
+            SimpleHttp::Response res;
+            res.headers["Content-Type"] = "text/plain";
+            res.body = body;
+            return res;
+        });
+    });
+    ::std::this_thread::sleep_for(::std::chrono::milliseconds(300));
+
+    const ::std::string request = "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ::std::atomic<bool> running(true);
+    ::std::vector<::std::vector<uint32_t>> latencies(options.connections);
+    ::std::vector<::std::thread> clients;
+
+    auto started = ::std::chrono::steady_clock::now();
+    for (int i = 0; i < options.connections; ++i) {
+        clients.emplace_back([&, i]() {
+            int fd = connectTo(port);
+            if (fd < 0) return;
+            ::std::string buffer;
+            auto& samples = latencies[i];
+            while (running) {
+                auto sent = ::std::chrono::steady_clock::now();
+                if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) < 0 || !readResponse(fd, buffer)) {
+                    break;
+                }
+                auto elapsed = ::std::chrono::steady_clock::now() - sent;
+                samples.push_back(static_cast<uint32_t>(
+                    ::std::chrono::duration_cast<::std::chrono::microseconds>(elapsed).count()));
+            }
+            close(fd);
+        });
+    }
+
+    ::std::this_thread::sleep_for(::std::chrono::seconds(options.seconds));
+    running = false;
+    for (auto& client : clients) {
+        client.join();
+    }
+    auto finished = ::std::chrono::steady_clock::now();
+
+    server.stop();
+    serverThread.join();
+
+    ::std::vector<uint32_t> all;
+    for (auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    BenchResult result;
+    result.requests = all.size();
+    result.seconds = ::std::chrono::duration<double>(finished - started).count();
+    if (!all.empty()) {
+        ::std::sort(all.begin(), all.end());
+        result.p50Us = all[all.size() / 2];
+        result.p99Us = all[all.size() * 99 / 100];
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        ::std::string arg = argv[i];
+        if (arg.rfind("--connections=", 0) == 0) {
+            options.connections = ::std::stoi(arg.substr(14));
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            options.seconds = ::std::stoi(arg.substr(10));
+        } else if (arg.rfind("--server-threads=", 0) == 0) {
+            options.serverThreads = ::std::stoi(arg.substr(17));
+        } else if (arg.rfind("--body=", 0) == 0) {
+            options.bodySize = ::std::stoul(arg.substr(7));
+        }
+    }
+
+    struct Backend {
+        const char* name;
+        SimpleHttp::IoModel model;
+    };
+    const Backend backends[] = {
+        {"epoll", SimpleHttp::IoModel::EPOLL},
+        {"io_uring", SimpleHttp::IoModel::IO_URING},
+    };
+
+    ::std::cout << options.connections << " connections, " << options.seconds << "s, "
+                << options.serverThreads << " server threads, " << options.bodySize << "-byte body" << ::std::endl;
+
+    int port = 18080;
+    for (const auto& backend : backends) {
+        BenchResult result = runBackend(backend.model, port++, options);
+        ::std::cout << ::std::left << ::std::setw(10) << backend.name
+                    << ::std::right << ::std::fixed << ::std::setprecision(0)
+                    << ::std::setw(10) << result.requests / result.seconds << " req/s"
+                    << "   p50 " << result.p50Us << "us"
+                    << "   p99 " << result.p99Us << "us" << ::std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Contention benchmark for the game registry: a single unordered_map behind one
+// mutex (the previous MemoryService layout) against the sharded GameRegistry,
+// at 1, 8 and 32 threads. Each operation is a lookup by game ID, or with
+// --write-percent probability an insert of a new game plus removal of an old one.
+//
+//   registry_bench [--seconds=2] [--games=10000] [--write-percent=10] [--shards=0]
+
+#include "game_registry.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+using MemoryTrainer::GameId;
+using MemoryTrainer::GameRegistry;
+using MemoryTrainer::IdHash;
+using MemoryTrainer::MemoryGame;
+
+struct BenchOptions {
+    int seconds = 2;
+    int games = 10000;
+    int writePercent = 10;
+    size_t shards = 0;                     // 0 = the registry default
+};
+
+class SingleMutexRegistry {
+public:
+    bool insert(const GameId& gameId, ::std::shared_ptr<MemoryGame> game) {
+        ::std::lock_guard<::std::mutex> lock(mutex_);
+        return games_.emplace(gameId, ::std::move(game)).second;
+    }
+    ::std::shared_ptr<MemoryGame> find(const GameId& gameId) {
+        ::std::lock_guard<::std::mutex> lock(mutex_);
+        auto it = games_.find(gameId);
+        return it != games_.end() ? it->second : nullptr;
+    }
+    bool erase(const GameId& gameId) {
+        ::std::lock_guard<::std::mutex> lock(mutex_);
+        return games_.erase(gameId) > 0;
+    }
+
+private:
+    ::std::unordered_map<GameId, ::std::shared_ptr<MemoryGame>, IdHash> games_;
+    ::std::mutex mutex_;
+};
+
+// Same layout as GameId::generate(): scrambled high word, sequential low word.
+GameId gameIdFor(uint64_t n) {
+    return GameId{(n + 1) * 0xD6E8FEB86659FD93ULL, n};
+}
+
+// Thread t owns IDs t, t + threads, t + 2 * threads, ... so inserts and
+// removals never collide; lookups go to any thread's range.
+template <typename Registry>
+double run(Registry& registry, int threadCount, const BenchOptions& options,
+           const ::std::shared_ptr<MemoryGame>& game) {
+    for (int i = 0; i < options.games; ++i) {
+        registry.insert(gameIdFor(i), game);
+    }
+
+    ::std::atomic<bool> running{true};
+    ::std::atomic<uint64_t> operations{0};
+    ::std::vector<::std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            ::std::mt19937 rng(t + 1);
+            ::std::uniform_int_distribution<int> percent(0, 99);
+            uint64_t oldest = t;
+            uint64_t next = t + ((options.games - 1 - t) / threadCount + 1) * threadCount;
+            uint64_t done = 0;
+            while (running.load(::std::memory_order_relaxed)) {
+                if (percent(rng) < options.writePercent && oldest < next) {
+                    registry.insert(gameIdFor(next), game);
+                    registry.erase(gameIdFor(oldest));
+                    next += threadCount;
+                    oldest += threadCount;
+                } else {
+                    uint64_t live = ::std::uniform_int_distribution<uint64_t>(0, options.games - 1)(rng);
+                    registry.find(gameIdFor(live));
+                }
+                ++done;
+            }
+            operations += done;
+        });
+    }
+
+    ::std::this_thread::sleep_for(::std::chrono::seconds(options.seconds));
+    running = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return operations.load() / static_cast<double>(options.seconds);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        ::std::string arg = argv[i];
+        if (arg.rfind("--seconds=", 0) == 0) {
+            options.seconds = ::std::stoi(arg.substr(10));
+        } else if (arg.rfind("--games=", 0) == 0) {
+            options.games = ::std::stoi(arg.substr(8));
+        } else if (arg.rfind("--write-percent=", 0) == 0) {
+            options.writePercent = ::std::stoi(arg.substr(16));
+        } else if (arg.rfind("--shards=", 0) == 0) {
+            options.shards = ::std::stoul(arg.substr(9));
+        }
+    }
+
+    auto game = ::std::make_shared<MemoryTrainer::SequenceGame>(MemoryTrainer::Difficulty::MEDIUM);
+    game->generate();
+
+    ::std::cout << options.games << " games, " << options.writePercent << "% writes, "
+                << options.seconds << "s per run" << ::std::endl;
+
+    for (int threadCount : {1, 8, 32}) {
+        SingleMutexRegistry single;
+        double singleOps = run(single, threadCount, options, game);
+        GameRegistry sharded(options.shards);
+        double shardedOps = run(sharded, threadCount, options, game);
+        ::std::cout << ::std::setw(3) << threadCount << " threads"
+                    << ::std::fixed << ::std::setprecision(0)
+                    << "   single mutex " << ::std::setw(10) << singleOps << " ops/s"
+                    << "   sharded (" << sharded.shardCount() << ") " << ::std::setw(10) << shardedOps << " ops/s"
+                    << ::std::endl;
+    }
+    return 0;
+}
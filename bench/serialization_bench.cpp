@@ -0,0 +1,128 @@
+// Serializes the two largest API payloads, a hard card board and a leaderboard,
+// with the same Writer calls in JSON and in CBOR, and reports the body size and
+// the time per serialization for each format.
+//
+//   serialization_bench [--iterations=200000] [--leaderboard=100]
+
+#include "json_writer.h"
+#include "card_pairs_game.h"
+#include "user.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+namespace {
+
+using SimpleJson::Format;
+using SimpleJson::Writer;
+
+struct BenchOptions {
+    int iterations = 200000;
+    int leaderboardSize = 100;
+};
+
+// Same shape as the GET /api/game/{id} response for a card game.
+void writeBoard(::std::string& out, Format format, const MemoryTrainer::CardPairsGame& game) {
+    Writer json(out, format);
+    json.beginObject()
+        .field("gameId", "9f3c61d2a84b07e5000000002e1b0004")
+        .field("type", "cards")
+        .field("difficulty", "hard")
+        .field("version", game.getVersion())
+        .key("cards").beginArray();
+    for (const auto& card : game.getCards()) {
+        json.beginObject()
+            .field("id", card.id)
+            .field("value", card.value)
+            .field("flipped", card.flipped)
+            .field("matched", card.matched)
+            .endObject();
+    }
+    json.endArray()
+        .field("moves", game.getMovesCount())
+        .field("pairsFound", game.getPairsFound())
+        .field("isComplete", game.isGameComplete())
+        .endObject();
+}
+
+// Same shape as the GET /api/leaderboard response.
+void writeLeaderboard(::std::string& out, Format format, const ::std::vector<MemoryTrainer::LeaderboardEntry>& entries) {
+    Writer json(out, format);
+    json.beginObject().key("leaderboard").beginArray();
+    for (const auto& entry : entries) {
+        json.beginObject()
+            .field("rank", entry.rank)
+            .field("username", entry.username)
+            .field("totalScore", entry.totalScore)
+            .field("gamesWon", entry.gamesWon)
+            .field("winRate", entry.winRate)
+            .endObject();
+    }
+    json.endArray().endObject();
+}
+
+void run(const char* payload, Format format, int iterations, const ::std::function<void(::std::string&, Format)>& write) {
+    ::std::string body;
+    write(body, format);
+    size_t bytes = body.size();
+
+    size_t sink = 0;
+    auto start = ::std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body.clear();
+        write(body, format);
+        sink += body.size();
+    }
+    double elapsedNs = ::std::chrono::duration<double, ::std::nano>(::std::chrono::steady_clock::now() - start).count();
+
+    ::std::cout << ::std::left << ::std::setw(14) << payload
+                << ::std::setw(6) << (format == Format::CBOR ? "cbor" : "json")
+                << ::std::right << ::std::setw(8) << bytes << " bytes"
+                << ::std::fixed << ::std::setprecision(0)
+                << ::std::setw(10) << elapsedNs / iterations << " ns/op"
+                << (sink == 0 ? " (empty)" : "") << ::std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        ::std::string arg = argv[i];
+        if (arg.rfind("--iterations=", 0) == 0) {
+            options.iterations = ::std::stoi(arg.substr(13));
+        } else if (arg.rfind("--leaderboard=", 0) == 0) {
+            options.leaderboardSize = ::std::stoi(arg.substr(14));
+        }
+    }
+
+    MemoryTrainer::CardPairsGame game(MemoryTrainer::Difficulty::HARD);
+    game.generate();
+    game.flipCard(0);
+    game.flipCard(1);
+    game.checkPair(0, 1);
+
+    ::std::vector<MemoryTrainer::LeaderboardEntry> entries;
+    for (int i = 0; i < options.leaderboardSize; ++i) {
+        entries.push_back({MemoryTrainer::UserId{0, static_cast<uint64_t>(i)}, "player_" + ::std::to_string(i),
+                           100000 - i * 37, 500 - i, 0.25 + i / 400.0, i + 1});
+    }
+
+    ::std::cout << options.iterations << " iterations, " << game.getCards().size() << " cards, "
+                << entries.size() << " leaderboard entries" << ::std::endl;
+
+    for (Format format : {Format::JSON, Format::CBOR}) {
+        run("board", format, options.iterations, [&game](::std::string& out, Format f) {
+            writeBoard(out, f, game);
+        });
+    }
+    for (Format format : {Format::JSON, Format::CBOR}) {
+        run("leaderboard", format, options.iterations / 10, [&entries](::std::string& out, Format f) {
+            writeLeaderboard(out, f, entries);
+        });
+    }
+    return 0;
+}
@@ -3,12 +3,26 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <cstdint>
 
 #include "memory_service.h"
 #include "user_service.h"
 
 namespace MemoryTrainer {
 
+class CardPairsGame;
+
+struct CardMove {
+    enum class Kind {
+        FLIP,
+        CHECK_PAIR
+    };
+    
+    Kind kind;
+    int cardId1;
+    int cardId2;                          // CHECK_PAIR only
+};
+
 class ApiController {
 public:
     ApiController(MemoryService& service, UserService& userService);
@@ -18,14 +32,33 @@ private:
     UserService& userService_;
     
     
+    // Card game responses take the client's last seen state version; since >= 0
+    // asks for only the cards changed after it instead of the full list.
     ::std::string handleCreateGame(const ::std::string& type, const ::std::string& difficulty, const ::std::string& sessionId);
-    ::std::string handleGetGame(const ::std::string& gameId);
+    ::std::string handleGetGame(const ::std::string& gameId, int64_t since);
+    // Full GET response in the current writer format, shared between requests
+    // until the game changes; null if there is no such game. Bodies of at least
+    // gzipMinSize also get a gzip variant (gzipLevel 0 = none).
+    ::std::shared_ptr<const GameSnapshot> handleGetGameSnapshot(const ::std::string& gameId, int gzipLevel, size_t gzipMinSize);
     ::std::string handleCheckAnswer(const ::std::string& gameId, const ::std::vector<int>& answer, const ::std::string& sessionId);
     ::std::string handleDeleteGame(const ::std::string& gameId);
     
     
-    ::std::string handleFlipCard(const ::std::string& gameId, int cardId);
-    ::std::string handleCheckCardPair(const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId);
+    ::std::string handleFlipCard(const ::std::string& gameId, int cardId, int64_t since);
+    ::std::string handleCheckCardPair(const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId, int64_t since);
+    
+    // WebSocket moves: only what changed, no cards array.
+    ::std::string handleFlipCardUpdate(const ::std::string& gameId, int cardId);
+    ::std::string handleCheckCardPairUpdate(const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId);
+    
+    ::std::string handleCardMoves(const ::std::string& gameId, const ::std::vector<CardMove>& moves, const ::std::string& sessionId, int64_t since);
+    
+    // Game and session IDs arrive as text and are parsed here; a malformed ID
+    // finds nothing, the same as an unknown one.
+    ::std::shared_ptr<MemoryGame> findGame(const ::std::string& gameId);
+    ::std::shared_ptr<CardPairsGame> findCardGame(const ::std::string& gameId);
+    ::std::shared_ptr<User> findSessionUser(const ::std::string& sessionId);
+    int finishCardGame(CardPairsGame& game, const ::std::string& sessionId);
     
     
     ::std::string handleRegister(const ::std::string& username, const ::std::string& email, const ::std::string& password);
@@ -44,8 +77,11 @@ public:
     static ::std::string createGame(ApiController& ctrl, const ::std::string& type, const ::std::string& difficulty, const ::std::string& sessionId = "") {
         return ctrl.handleCreateGame(type, difficulty, sessionId);
     }
-    static ::std::string getGame(ApiController& ctrl, const ::std::string& gameId) {
-        return ctrl.handleGetGame(gameId);
+    static ::std::string getGame(ApiController& ctrl, const ::std::string& gameId, int64_t since = -1) {
+        return ctrl.handleGetGame(gameId, since);
+    }
+    static ::std::shared_ptr<const GameSnapshot> gameSnapshot(ApiController& ctrl, const ::std::string& gameId, int gzipLevel = 0, size_t gzipMinSize = 0) {
+        return ctrl.handleGetGameSnapshot(gameId, gzipLevel, gzipMinSize);
     }
     static ::std::string checkAnswer(ApiController& ctrl, const ::std::string& gameId, const ::std::vector<int>& answer, const ::std::string& sessionId = "") {
         return ctrl.handleCheckAnswer(gameId, answer, sessionId);
@@ -53,11 +89,20 @@ public:
     static ::std::string deleteGame(ApiController& ctrl, const ::std::string& gameId) {
         return ctrl.handleDeleteGame(gameId);
     }
-    static ::std::string flipCard(ApiController& ctrl, const ::std::string& gameId, int cardId) {
-        return ctrl.handleFlipCard(gameId, cardId);
+    static ::std::string flipCard(ApiController& ctrl, const ::std::string& gameId, int cardId, int64_t since = -1) {
+        return ctrl.handleFlipCard(gameId, cardId, since);
+    }
+    static ::std::string checkCardPair(ApiController& ctrl, const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId = "", int64_t since = -1) {
+        return ctrl.handleCheckCardPair(gameId, cardId1, cardId2, sessionId, since);
     }
-    static ::std::string checkCardPair(ApiController& ctrl, const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId = "") {
-        return ctrl.handleCheckCardPair(gameId, cardId1, cardId2, sessionId);
+    static ::std::string flipCardUpdate(ApiController& ctrl, const ::std::string& gameId, int cardId) {
+        return ctrl.handleFlipCardUpdate(gameId, cardId);
+    }
+    static ::std::string checkCardPairUpdate(ApiController& ctrl, const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId = "") {
+        return ctrl.handleCheckCardPairUpdate(gameId, cardId1, cardId2, sessionId);
+    }
+    static ::std::string cardMoves(ApiController& ctrl, const ::std::string& gameId, const ::std::vector<CardMove>& moves, const ::std::string& sessionId = "", int64_t since = -1) {
+        return ctrl.handleCardMoves(gameId, moves, sessionId, since);
     }
     static ::std::string registerUser(ApiController& ctrl, const ::std::string& username, const ::std::string& email, const ::std::string& password) {
         return ctrl.handleRegister(username, email, password);
@@ -74,6 +119,9 @@ public:
     static ::std::string getLeaderboard(ApiController& ctrl, int limit = 10) {
         return ctrl.handleGetLeaderboard(limit);
     }
+    static ::std::shared_ptr<MemoryGame> findGame(ApiController& ctrl, const ::std::string& gameId) {
+        return ctrl.findGame(gameId);
+    }
 };
 
 } 
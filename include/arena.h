@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SimpleHttp {
+
+// Monotonic bump allocator for per-request temporaries. Memory comes from a
+// chain of blocks and is only reclaimed by reset(), which rewinds to the first
+// block in O(1) and keeps the chain for the next request.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 16 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(::std::max_align_t));
+    ::std::string_view copy(::std::string_view text);
+    void reset();
+
+    // Arena picked up by default-constructed ArenaAllocators on this thread;
+    // the server installs the connection arena while a handler runs.
+    static Arena* current() { return current_; }
+
+private:
+    friend class ArenaScope;
+
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    Block* nextBlock(size_t minSize);
+
+    Block* first_ = nullptr;
+    Block* block_ = nullptr;
+    size_t offset_ = 0;
+    size_t blockSize_;
+
+    static thread_local Arena* current_;
+};
+
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena* arena) : previous_(Arena::current_) { Arena::current_ = arena; }
+    ~ArenaScope() { Arena::current_ = previous_; }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena* previous_;
+};
+
+// Standard allocator over an Arena; deallocate is a no-op. Without an arena
+// (outside a request) it falls back to the heap.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept : arena_(Arena::current()) {}
+    explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (!arena_) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t) noexcept {
+        if (!arena_) {
+            ::operator delete(p);
+        }
+    }
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena(); }
+
+private:
+    Arena* arena_;
+};
+
+using ArenaString = ::std::basic_string<char, ::std::char_traits<char>, ArenaAllocator<char>>;
+
+template <typename T>
+using ArenaVector = ::std::vector<T, ArenaAllocator<T>>;
+
+}
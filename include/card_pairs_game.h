@@ -3,6 +3,9 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <mutex>
+#include <cstdint>
+#include <atomic>
 
 #include "memory_game.h"
 
@@ -14,8 +17,9 @@ struct Card {
     int value;        
     bool flipped;     
     bool matched;     
+    uint64_t version; // game version of the last change to this card
     
-    Card(int cardId, int val) : id(cardId), value(val), flipped(false), matched(false) {}
+    Card(int cardId, int val) : id(cardId), value(val), flipped(false), matched(false), version(0) {}
 };
 
 
@@ -24,11 +28,14 @@ public:
     CardPairsGame(Difficulty difficulty);
     
     void generate() override;
+    // The version keeps counting across reuse, so nothing cached for the
+    // previous game can match the new one.
+    void reset(Difficulty difficulty) override;
     GameResult checkAnswer(const ::std::vector<int>& answer) override;
     ::std::vector<int> getSequence() const override;
     
     
-    ::std::vector<Card> getCards() const { return cards_; }
+    const ::std::vector<Card>& getCards() const { return cards_; }
     bool flipCard(int cardId);
     ::std::pair<int, int> getFlippedCards() const; 
     bool checkPair(int cardId1, int cardId2);
@@ -38,12 +45,25 @@ public:
     int getCardCount() const; 
     void resetFlippedCards();
     
+    // Bumped by every move; cards remember the version that last changed them.
+    uint64_t getVersion() const { return version_.load(::std::memory_order_acquire); }
+    uint64_t getStateVersion() const override { return getVersion(); }
+    // True if the cards changed after `since` describe every difference from that
+    // version; otherwise (unknown or pre-deal version) the client needs all cards.
+    bool hasChangesSince(uint64_t since) const { return since >= dealtVersion_ && since <= version_; }
+    
+    // Held by callers for the whole of a move, or a batch of moves, and the state read back after it.
+    ::std::mutex& mutex() { return mutex_; }
+    
 private:
+    ::std::mutex mutex_;
     ::std::vector<Card> cards_;
     ::std::vector<int> flippedCardIds_; 
     int movesCount_ = 0;
     int pairsFound_ = 0;
     int totalPairs_ = 0;
+    ::std::atomic<uint64_t> version_{0};   // written under mutex_, read without it for cache checks
+    uint64_t dealtVersion_ = 0;
     
     void shuffleCards();
 };
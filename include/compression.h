@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "http_server.h"
+
+namespace SimpleHttp {
+
+::std::string gzipCompress(const ::std::string& data, int level);
+
+bool acceptsGzip(const Request& req);
+
+bool isCompressibleType(const ::std::string& contentType);
+
+}
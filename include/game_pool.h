@@ -0,0 +1,181 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#include "memory_game.h"
+
+namespace MemoryTrainer {
+
+struct GamePoolStats {
+    size_t capacity = 0;                   // games constructed in slab storage so far
+    size_t inUse = 0;
+    size_t highWater = 0;                  // most games in use at once
+    uint64_t acquired = 0;
+    uint64_t reused = 0;                   // acquisitions served by a recycled game
+};
+
+// Slab pool for one game type. A released game stays constructed on a free
+// list and is handed out again after reset(), so its vectors keep their
+// capacity and its generator its state; the shared_ptr control blocks come from
+// pooled slabs as well, so a steady churn of games never reaches the heap.
+// Slabs are kept until the last game and the pool itself are gone.
+template <typename T>
+class GamePool {
+public:
+    explicit GamePool(size_t slabSize = 64) : state_(::std::make_shared<State>(slabSize)) {}
+
+    ::std::shared_ptr<T> acquire(Difficulty difficulty) {
+        T* game = state_->take(difficulty);
+        return ::std::shared_ptr<T>(game, Recycle{state_.get()}, BlockAllocator<T>(state_));
+    }
+
+    GamePoolStats stats() const {
+        ::std::lock_guard<::std::mutex> lock(state_->mutex);
+        return state_->stats;
+    }
+
+private:
+    // Room for libstdc++'s control block holding a Recycle and a BlockAllocator.
+    static const size_t kBlockSize = 64;
+
+    struct State {
+        explicit State(size_t slabSize) : slabSize(slabSize ? slabSize : 1) {}
+
+        // Only reached once every game has come back, so all constructed games are free.
+        ~State() {
+            for (T* game : freeGames) {
+                game->~T();
+            }
+            for (void* slab : slabs) {
+                ::operator delete(slab);
+            }
+        }
+
+        T* take(Difficulty difficulty) {
+            T* game = nullptr;
+            void* storage = nullptr;
+            {
+                ::std::lock_guard<::std::mutex> lock(mutex);
+                ++stats.acquired;
+                ++stats.inUse;
+                if (stats.inUse > stats.highWater) {
+                    stats.highWater = stats.inUse;
+                }
+                if (!freeGames.empty()) {
+                    game = freeGames.back();
+                    freeGames.pop_back();
+                    ++stats.reused;
+                } else {
+                    storage = carve(freshGames, freshGamesLeft, sizeof(T));
+                    ++stats.capacity;
+                }
+            }
+            if (game) {
+                game->reset(difficulty);
+                return game;
+            }
+            return new (storage) T(difficulty);
+        }
+
+        void release(T* game) {
+            ::std::lock_guard<::std::mutex> lock(mutex);
+            freeGames.push_back(game);
+            --stats.inUse;
+        }
+
+        void* takeBlock() {
+            ::std::lock_guard<::std::mutex> lock(mutex);
+            if (!freeBlocks.empty()) {
+                void* block = freeBlocks.back();
+                freeBlocks.pop_back();
+                return block;
+            }
+            return carve(freshBlocks, freshBlocksLeft, kBlockSize);
+        }
+
+        void releaseBlock(void* block) {
+            ::std::lock_guard<::std::mutex> lock(mutex);
+            freeBlocks.push_back(block);
+        }
+
+        // Next unused slot of the current slab, starting a new slab when it is
+        // exhausted. Called with mutex held.
+        void* carve(char*& fresh, size_t& left, size_t size) {
+            if (left == 0) {
+                fresh = static_cast<char*>(::operator new(size * slabSize));
+                slabs.push_back(fresh);
+                left = slabSize;
+            }
+            void* slot = fresh;
+            fresh += size;
+            --left;
+            return slot;
+        }
+
+        ::std::mutex mutex;
+        size_t slabSize;
+        ::std::vector<void*> slabs;
+        ::std::vector<T*> freeGames;
+        ::std::vector<void*> freeBlocks;
+        char* freshGames = nullptr;
+        size_t freshGamesLeft = 0;
+        char* freshBlocks = nullptr;
+        size_t freshBlocksLeft = 0;
+        GamePoolStats stats;
+    };
+
+    // Runs while the control block, and the allocator copy in it, still
+    // keeps the state alive.
+    struct Recycle {
+        State* state;
+        void operator()(T* game) const { state->release(game); }
+    };
+
+    template <typename U>
+    struct BlockAllocator {
+        using value_type = U;
+        template <typename V>
+        struct rebind {
+            using other = BlockAllocator<V>;
+        };
+
+        explicit BlockAllocator(::std::shared_ptr<State> s) : state(::std::move(s)) {}
+        template <typename V>
+        BlockAllocator(const BlockAllocator<V>& other) : state(other.state) {}
+
+        static bool pooled(size_t n) {
+            return n == 1 && sizeof(U) <= kBlockSize && alignof(U) <= alignof(::std::max_align_t);
+        }
+
+        U* allocate(size_t n) {
+            if (pooled(n)) {
+                return static_cast<U*>(state->takeBlock());
+            }
+            return static_cast<U*>(::operator new(n * sizeof(U)));
+        }
+
+        void deallocate(U* p, size_t n) {
+            if (pooled(n)) {
+                state->releaseBlock(p);
+            } else {
+                ::operator delete(p);
+            }
+        }
+
+        template <typename V>
+        bool operator==(const BlockAllocator<V>& other) const { return state == other.state; }
+        template <typename V>
+        bool operator!=(const BlockAllocator<V>& other) const { return state != other.state; }
+
+        ::std::shared_ptr<State> state;
+    };
+
+    ::std::shared_ptr<State> state_;
+};
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+#include <cstddef>
+
+#include "memory_game.h"
+#include "ids.h"
+
+namespace MemoryTrainer {
+
+// Games by ID, split into independently locked shards picked by a hash of the
+// ID, so requests for different games rarely wait on the same mutex. Bulk
+// operations walk the shards one at a time and never hold more than one lock.
+class GameRegistry {
+public:
+    using Visitor = ::std::function<void(const GameId& gameId, const ::std::shared_ptr<MemoryGame>& game)>;
+    using Predicate = ::std::function<bool(const GameId& gameId, const MemoryGame& game)>;
+
+    // Rounded up to a power of two; 0 = 4 * hardware_concurrency.
+    explicit GameRegistry(size_t shardCount = 0);
+
+    // False, leaving the registry unchanged, if the ID is already taken.
+    bool insert(const GameId& gameId, ::std::shared_ptr<MemoryGame> game);
+    ::std::shared_ptr<MemoryGame> find(const GameId& gameId) const;
+    bool erase(const GameId& gameId);
+
+    void clear();
+    size_t size() const;
+    size_t shardCount() const { return shardCount_; }
+
+    // Visitors and predicates run under the shard lock and must not call back
+    // into the registry.
+    void forEach(const Visitor& visit) const;
+    // Removes the games pred selects; returns how many went.
+    size_t eraseIf(const Predicate& pred);
+    // The same within one shard, stopping after limit removals so the lock is
+    // held for a bounded time; call again while it returns limit.
+    size_t eraseIf(size_t shard, const Predicate& pred, size_t limit);
+
+private:
+    struct alignas(64) Shard {
+        mutable ::std::mutex mutex;
+        ::std::unordered_map<GameId, ::std::shared_ptr<MemoryGame>, IdHash> games;
+    };
+
+    Shard& shardFor(const GameId& gameId) const;
+
+    size_t shardCount_;
+    unsigned shardBits_;
+    ::std::unique_ptr<Shard[]> shards_;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+
+#include "http_server.h"
+
+namespace SimpleHttp {
+
+bool equalsIgnoreCase(::std::string_view a, ::std::string_view b);
+
+// Decodes %XX escapes (and '+' as space when plusAsSpace) in place; returns the decoded length.
+size_t percentDecode(char* data, size_t size, bool plusAsSpace);
+
+// Incremental HTTP/1.x request parser working directly on the connection buffer.
+// Between calls the buffer may grow or move; the parser only keeps offsets, so a
+// header block split across several recv() calls is scanned once.
+class RequestParser {
+public:
+    enum class Status {
+        INCOMPLETE,
+        COMPLETE,
+        BAD_REQUEST,
+        NOT_IMPLEMENTED                    // Transfer-Encoding: bodies are framed by Content-Length only
+    };
+
+    // data points at the first unconsumed byte. On COMPLETE, req holds views into
+    // data (query parameters are decoded in place) and requestSize() bytes belong
+    // to this request.
+    Status parse(char* data, size_t size, Request& req);
+
+    size_t requestSize() const { return headerSize_ + contentLength_; }
+    bool headersComplete() const { return headerSize_ != 0; }
+    void reset();
+
+private:
+    // COMPLETE when the head is usable.
+    Status parseHead(char* data, Request& req);
+
+    size_t scanned_ = 0;
+    size_t headerSize_ = 0;
+    size_t contentLength_ = 0;
+    size_t queryOffset_ = 0;
+    size_t queryLength_ = 0;
+};
+
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "arena.h"
+
+namespace SimpleHttp {
+
+struct CaseInsensitiveLess {
+    bool operator()(const ::std::string& a, const ::std::string& b) const;
+};
+
+using HeaderMap = ::std::map<::std::string, ::std::string, CaseInsensitiveLess>;
+
+struct HeaderField {
+    ::std::string_view name;
+    ::std::string_view value;
+};
+
+struct QueryParam {
+    ::std::string_view name;
+    ::std::string_view value;
+};
+
+// Views into the connection buffer; valid only for the duration of the handler call.
+struct Request {
+    static const size_t kMaxHeaders = 64;
+    static const size_t kMaxQueryParams = 32;
+
+    ::std::string_view method;
+    ::std::string_view path;
+    ::std::string_view version;
+    ::std::string_view body;
+    HeaderField headers[kMaxHeaders];
+    size_t headerCount = 0;
+    QueryParam queryParams[kMaxQueryParams];
+    size_t queryParamCount = 0;
+    Arena* arena = nullptr;                // scratch memory, reset once the response is queued
+    uint32_t remoteAddress = 0;            // peer IPv4 address in network byte order, 0 if unknown
+
+    ::std::string_view header(::std::string_view name) const;
+    bool hasHeader(::std::string_view name) const;
+    ::std::string_view query(::std::string_view name, ::std::string_view fallback = {}) const;
+    bool hasQuery(::std::string_view name) const;
+    bool keepAlive() const;
+};
+
+class WebSocketHandler;
+
+// Body streamed from an open file with sendfile; owner keeps the descriptor alive until sent.
+struct FileBody {
+    int fd = -1;
+    size_t size = 0;
+    ::std::shared_ptr<const void> owner;
+};
+
+// Body bytes borrowed from a long-lived buffer (cached assets, prebuilt payloads);
+// owner keeps them alive until the response has been written.
+struct SharedBody {
+    ::std::string_view data;
+    ::std::shared_ptr<const void> owner;
+};
+
+struct Response {
+    int statusCode = 200;
+    ::std::string body;
+    HeaderMap headers;
+    FileBody file;
+    SharedBody shared;
+    ::std::shared_ptr<WebSocketHandler> upgrade;   // set by acceptWebSocket on a 101
+
+    ::std::string_view bodyView() const { return shared.owner ? shared.data : ::std::string_view(body); }
+
+    // Status line and headers only; the body is written as separate segments.
+    ::std::string serializeHead() const;
+    ::std::string toString() const;
+};
+
+const char* reasonPhrase(int statusCode);
+
+// If-None-Match check: true when the field is exactly "*" or one of its
+// comma-separated entity tags equals etag, W/ prefixes ignored.
+bool etagMatches(::std::string_view header, ::std::string_view etag);
+
+using Handler = ::std::function<Response(const Request&)>;
+
+enum class IoModel {
+    THREAD_POOL,
+    EPOLL,
+    IO_URING                               // falls back to EPOLL when the kernel has no io_uring
+};
+
+struct ServerConfig {
+    IoModel ioModel = IoModel::EPOLL;
+    int eventLoopThreads = 0;              // 0 = hardware_concurrency
+    int workerThreads = 0;                 // 0 = 4 * hardware_concurrency
+    size_t maxQueuedConnections = 1024;
+    int listenBacklog = 1024;
+    int reusePortListeners = 0;            // >0 opens that many SO_REUSEPORT sockets, one acceptor each
+    int retryAfterSeconds = 1;
+    size_t maxRequestSize = 64 * 1024;
+    int keepAliveTimeoutMs = 5000;         // idle time between requests
+    int headerTimeoutMs = 10000;           // from the first byte of a request to the end of its headers
+    int bodyTimeoutMs = 30000;             // from the end of the headers to the end of the body
+    int writeTimeoutMs = 30000;            // without any progress writing a response
+    int webSocketIdleTimeoutMs = 60000;    // between messages on an upgraded connection
+    int maxRequestsPerConnection = 100;
+    int compressionLevel = 6;              // 0 disables response compression
+    size_t compressionMinSize = 1024;
+};
+
+struct ListenerStats {
+    uint64_t acceptedConnections = 0;
+    uint64_t activeConnections = 0;
+};
+
+struct ServerStats {
+    uint64_t acceptedConnections = 0;
+    uint64_t rejectedConnections = 0;
+    uint64_t timedOutConnections = 0;
+    uint64_t activeConnections = 0;
+    size_t queueDepth = 0;
+    size_t queueCapacity = 0;
+    ::std::vector<ListenerStats> listeners;
+};
+
+struct Connection;
+class TimerWheel;
+class RateLimiter;
+
+class Server {
+public:
+    Server(int port);
+    Server(int port, const ServerConfig& config);
+
+    // Checked for every parsed request before the handler runs; must outlive the server.
+    void setRateLimiter(RateLimiter* limiter);
+
+    void start(Handler handler);
+    void stop();
+
+    ServerStats stats();
+
+private:
+    struct ListenerCounters {
+        ::std::atomic<uint64_t> accepted{0};
+        ::std::atomic<uint64_t> active{0};
+    };
+
+    struct PendingConnection {
+        int fd;
+        ListenerCounters* listener;
+    };
+
+    int openListenSocket(bool reusePort);
+
+    void runWorkerPool(const ::std::vector<int>& listenSockets);
+    void acceptLoop(int serverSocket, ListenerCounters& listener);
+    void workerLoop();
+    void rejectConnection(int clientSocket);
+    void runEventLoops(const ::std::vector<int>& listenSockets);
+    void eventLoop(int serverSocket, bool shared, ListenerCounters& listener);
+    void uringLoop(int serverSocket, ListenerCounters& listener);
+
+    void handleClient(int clientSocket);
+    bool processRequests(Connection& conn);
+    bool processFrames(Connection& conn);
+    bool updatePhase(Connection& conn, uint64_t nowMs, uint64_t& deadlineMs);
+    void armTimeout(Connection& conn, TimerWheel& timers, uint64_t nowMs);
+    bool rateLimited(const Request& req, Response& res);
+    Response dispatch(const Request& req);
+    void compressResponse(const Request& req, Response& res);
+
+    int port_;
+    ServerConfig config_;
+    ::std::atomic<bool> running_;
+    Handler handler_;
+    RateLimiter* rateLimiter_ = nullptr;
+
+    ::std::vector<::std::unique_ptr<ListenerCounters>> listeners_;
+
+    ::std::deque<PendingConnection> pendingSockets_;
+    ::std::mutex queueMutex_;
+    ::std::condition_variable queueCv_;
+
+    ::std::atomic<uint64_t> acceptedConnections_{0};
+    ::std::atomic<uint64_t> rejectedConnections_{0};
+    ::std::atomic<uint64_t> timedOutConnections_{0};
+    ::std::atomic<uint64_t> activeConnections_{0};
+};
+
+}
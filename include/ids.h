@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace MemoryTrainer {
+
+// 128-bit key for games, users and sessions: a process-wide unique sequence
+// number in low and 64 bits from the system CSPRNG in high, so two IDs never
+// collide within a process and one ID says nothing about the next. Registries
+// key on the binary value; text exists only at the API boundary and on disk.
+struct Id {
+    uint64_t high = 0;
+    uint64_t low = 0;
+
+    // Lock-free: each thread draws sequence numbers from its own block and
+    // random bits from its own buffer.
+    static Id generate();
+
+    // 32 lowercase hex digits; that exact form is the only one parse() accepts.
+    static bool parse(::std::string_view text, Id& out);
+    ::std::string toString() const;
+
+    bool empty() const { return high == 0 && low == 0; }
+    bool operator==(const Id& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const Id& other) const { return !(*this == other); }
+};
+
+struct IdHash {
+    size_t operator()(const Id& id) const {
+        return static_cast<size_t>(id.high ^ (id.low * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+using GameId = Id;
+using UserId = Id;
+using SessionId = Id;
+
+}
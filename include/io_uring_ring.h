@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct msghdr;
+
+namespace SimpleHttp {
+
+struct IoCompletion {
+    uint64_t userData;
+    int32_t result;
+    bool more;                             // a multishot request stays armed
+};
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing dependency).
+// Not thread-safe: each event loop owns its ring. Prepared requests are queued
+// in the submission ring and handed to the kernel in one batch by submitAndWait().
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Returns false (with errno set) when the kernel or build has no io_uring.
+    bool init(unsigned entries);
+    static bool available();
+
+    void prepareAccept(int fd, bool multishot, uint64_t userData);
+    void prepareRecv(int fd, void* buffer, size_t length, uint64_t userData);
+    void prepareSendMsg(int fd, const msghdr* message, uint64_t userData);
+    void prepareRead(int fd, void* buffer, size_t length, uint64_t offset, uint64_t userData);
+    void prepareClose(int fd, uint64_t userData);
+    void prepareTimeout(unsigned milliseconds, uint64_t userData);
+
+    // Submits everything prepared so far and blocks until at least waitFor completions are ready.
+    int submitAndWait(unsigned waitFor);
+    bool nextCompletion(IoCompletion& completion);
+
+private:
+    void* nextEntry();
+
+    int ringFd_ = -1;
+    void* sqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    void* cqRing_ = nullptr;
+    size_t cqRingSize_ = 0;
+    void* sqEntries_ = nullptr;
+    size_t sqEntriesSize_ = 0;
+
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqCapacity_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    void* cqes_ = nullptr;
+
+    unsigned pending_ = 0;
+    int64_t timeout_[2] = {0, 0};          // __kernel_timespec for prepareTimeout
+};
+
+}
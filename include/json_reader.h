@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+#include "arena.h"
+
+namespace SimpleJson {
+
+class Document;
+
+enum class Type : uint8_t {
+    MISSING,                               // looked-up key or index that is not there
+    NULL_VALUE,
+    BOOL,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT
+};
+
+// Cheap handle into a Document; valid as long as the document is.
+class Value {
+public:
+    class Iterator {
+    public:
+        Iterator(const Document* doc, uint32_t index) : doc_(doc), index_(index) {}
+        Value operator*() const { return Value(doc_, index_); }
+        Iterator& operator++();
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const Document* doc_;
+        uint32_t index_;
+    };
+
+    Value() = default;
+
+    Type type() const;
+    bool exists() const { return type() != Type::MISSING; }
+    bool isString() const { return type() == Type::STRING; }
+    bool isNumber() const { return type() == Type::NUMBER; }
+    bool isArray() const { return type() == Type::ARRAY; }
+    bool isObject() const { return type() == Type::OBJECT; }
+
+    // Typed access; a value of another type yields the fallback.
+    ::std::string_view asString(::std::string_view fallback = {}) const;
+    bool asBool(bool fallback = false) const;
+    double asDouble(double fallback = 0) const;
+    // Integral numbers within range only: 1.5 or 1e99 yield the fallback.
+    bool getInt(int& out) const;
+    int asInt(int fallback = 0) const;
+
+    // Object member by key (first match); MISSING if absent or not an object.
+    Value operator[](::std::string_view key) const;
+
+    // Number of array elements or object members.
+    size_t size() const;
+
+    // Array elements in order; empty for anything else.
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    friend class Document;
+
+    Value(const Document* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+    const Document* doc_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+// Validating JSON parser (RFC 8259) that flattens the text into a tape of
+// nodes, each container recording where its subtree ends so lookups skip
+// whole members. The tape and any unescaped strings live in the current
+// request arena; strings without escapes are views into the input, which must
+// outlive the document. String scanning uses SSE2 where available.
+class Document {
+public:
+    static const size_t kDefaultMaxDepth = 32;
+    static const size_t kDefaultMaxSize = 64 * 1024;
+
+    explicit Document(size_t maxDepth = kDefaultMaxDepth, size_t maxSize = kDefaultMaxSize);
+
+    bool parse(::std::string_view text);
+
+    Value root() const { return nodes_.empty() ? Value() : Value(this, 0); }
+    Value operator[](::std::string_view key) const { return root()[key]; }
+
+    // Why parse() failed and at which byte offset.
+    const char* error() const { return error_; }
+    size_t errorOffset() const { return errorOffset_; }
+
+private:
+    friend class Value;
+
+    struct Node {
+        Type type;
+        uint32_t end;                      // index one past this node's subtree
+        uint32_t count;                    // array elements or object members
+        ::std::string_view text;           // string contents, number literal, or "true"/"false"
+    };
+
+    bool fail(const char* message);
+    void skipWhitespace();
+    bool parseValue(size_t depth);
+    bool parseString(::std::string_view& out);
+    bool parseNumber();
+    bool parseLiteral(::std::string_view literal, Type type);
+    bool parseContainer(size_t depth, bool object);
+
+    const Node* node(uint32_t index) const { return index < nodes_.size() ? &nodes_[index] : nullptr; }
+
+    size_t maxDepth_;
+    size_t maxSize_;
+    const char* begin_ = nullptr;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+    SimpleHttp::ArenaVector<Node> nodes_;
+    SimpleHttp::ArenaVector<char> unescaped_;   // sized to the input on the first escape, never regrown
+    size_t unescapedSize_ = 0;
+    const char* error_ = nullptr;
+    size_t errorOffset_ = 0;
+};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace SimpleJson {
+
+enum class Format {
+    JSON,
+    CBOR                                   // RFC 8949, containers as indefinite-length items
+};
+
+// Appends JSON straight into out in one pass: commas and nesting are tracked
+// by the writer, numbers go through to_chars and strings are escaped as they
+// are copied. Values are typed, so a string is always quoted and a number never is.
+// The same calls produce CBOR instead when the writer is built for it; by default
+// it uses the format of the innermost FormatScope on this thread.
+//
+//     Writer json(body);
+//     json.beginObject().field("gameId", id).key("cards").beginArray();
+//     ...
+//     json.endArray().endObject();
+class Writer {
+public:
+    explicit Writer(::std::string& out) : out_(out), format_(current_) {}
+    Writer(::std::string& out, Format format) : out_(out), format_(format) {}
+
+    Format format() const { return format_; }
+    // Format of the innermost FormatScope on this thread.
+    static Format currentFormat() { return current_; }
+
+    Writer& beginObject();
+    Writer& endObject();
+    Writer& beginArray();
+    Writer& endArray();
+
+    Writer& key(::std::string_view name);
+
+    Writer& value(::std::string_view text);
+    Writer& value(const char* text) { return value(::std::string_view(text)); }
+    Writer& value(const ::std::string& text) { return value(::std::string_view(text)); }
+    Writer& value(bool flag);
+    Writer& value(int number) { return value(static_cast<long long>(number)); }
+    Writer& value(long number) { return value(static_cast<long long>(number)); }
+    Writer& value(long long number);
+    Writer& value(unsigned number) { return value(static_cast<unsigned long long>(number)); }
+    Writer& value(unsigned long number) { return value(static_cast<unsigned long long>(number)); }
+    Writer& value(unsigned long long number);
+    Writer& value(double number);          // NaN and infinities become null
+    Writer& null();
+
+    // One value already serialized in this writer's format, inserted as is.
+    Writer& raw(::std::string_view encoded);
+
+    template <typename T>
+    Writer& field(::std::string_view name, const T& fieldValue) {
+        key(name);
+        return value(fieldValue);
+    }
+
+    Writer& array(const int* values, size_t count);
+
+private:
+    friend class FormatScope;
+
+    static const unsigned kMaxDepth = 64;
+
+    void separate();
+    void open(char bracket);
+    void close(char bracket);
+    void cborHead(unsigned major, uint64_t argument);
+    void cborString(::std::string_view text);
+
+    static thread_local Format current_;
+
+    ::std::string& out_;
+    Format format_;
+    unsigned depth_ = 0;
+    uint64_t hasItems_ = 0;                // bit per nesting level
+    bool afterKey_ = false;
+};
+
+// Selects the format of default-constructed writers for as long as it lives,
+// e.g. around a request handler after content negotiation.
+class FormatScope {
+public:
+    explicit FormatScope(Format format) : previous_(Writer::current_) { Writer::current_ = format; }
+    ~FormatScope() { Writer::current_ = previous_; }
+
+    FormatScope(const FormatScope&) = delete;
+    FormatScope& operator=(const FormatScope&) = delete;
+
+private:
+    Format previous_;
+};
+
+const char* contentType(Format format);
+
+// Quotes and escapes text: control characters as \n-style or \u00XX escapes,
+// valid UTF-8 passed through, invalid bytes replaced with U+FFFD.
+void appendString(::std::string& out, ::std::string_view text);
+
+}
@@ -6,6 +6,8 @@
 #include <random>
 #include <chrono>
 #include <cstdint>
+#include <mutex>
+#include <atomic>
 
 namespace MemoryTrainer {
 
@@ -28,13 +30,28 @@ struct GameResult {
     ::std::string message;
 };
 
+// A serialized GET response and the state version it was built from.
+struct GameSnapshot {
+    uint64_t version;
+    ::std::string etag;
+    ::std::string body;
+    ::std::string gzipBody;                // empty when gzip does not pay off
+    ::std::string gzipEtag;
+};
+
 class MemoryGame {
 public:
+    static const size_t kSnapshotSlots = 2;   // one per response encoding
+
     MemoryGame(GameType type, Difficulty difficulty);
     virtual ~MemoryGame() = default;
 
     virtual void generate() = 0;
     
+    // Back to the just-constructed state for a pooled game that is handed out
+    // again; buffers keep their capacity and the generator its state.
+    virtual void reset(Difficulty difficulty);
+    
     virtual GameResult checkAnswer(const ::std::vector<int>& answer) = 0;
     
     virtual ::std::vector<int> getSequence() const = 0;
@@ -43,6 +60,19 @@ public:
     Difficulty getDifficulty() const { return difficulty_; }
     
     int getMemorizationTime() const;
+    
+    // Changes whenever anything a GET response shows changes; games without
+    // moves never change after generate().
+    virtual uint64_t getStateVersion() const { return 0; }
+    
+    // Last GET response built for an encoding slot; stale once its version
+    // differs from getStateVersion().
+    ::std::shared_ptr<const GameSnapshot> getSnapshot(size_t slot) const;
+    void setSnapshot(size_t slot, ::std::shared_ptr<const GameSnapshot> snapshot);
+    
+    // Steady-clock milliseconds of the last lookup, for idle expiry.
+    void touch(int64_t nowMs) { lastAccessMs_.store(nowMs, ::std::memory_order_relaxed); }
+    int64_t getLastAccessMs() const { return lastAccessMs_.load(::std::memory_order_relaxed); }
 
 protected:
     GameType type_;
@@ -52,6 +82,11 @@ protected:
     
     int getSequenceLength() const;
     int getNumberRange() const;
+
+private:
+    mutable ::std::mutex snapshotMutex_;
+    ::std::shared_ptr<const GameSnapshot> snapshots_[kSnapshotSlots];
+    ::std::atomic<int64_t> lastAccessMs_{0};
 };
 
 class SequenceGame : public MemoryGame {
@@ -1,30 +1,131 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <cstdint>
 
 #include "memory_game.h"
+#include "game_registry.h"
+#include "ids.h"
+#include "game_pool.h"
+#include "card_pairs_game.h"
 
 namespace MemoryTrainer {
 
+// Ready-made games for one game type and difficulty.
+struct ReadyPoolStats {
+    GameType type = GameType::SEQUENCE;
+    Difficulty difficulty = Difficulty::MEDIUM;
+    size_t ready = 0;
+    size_t target = 0;
+    double createRate = 0;                 // games per second, smoothed
+    uint64_t hits = 0;                     // creations served from the pool
+    uint64_t misses = 0;                   // generated in the request, pool empty
+    int64_t refillLagMs = 0;               // how long the pool has been below target
+    int64_t maxRefillLagMs = 0;
+};
+
+struct GameStats {
+    size_t active = 0;
+    size_t shards = 0;
+    uint64_t created = 0;
+    uint64_t deleted = 0;                  // by DELETE /api/game/{id}
+    uint64_t expired = 0;                  // by the reaper
+    GamePoolStats sequencePool;
+    GamePoolStats cardPool;
+    ::std::vector<ReadyPoolStats> ready;
+};
+
 class MemoryService {
 public:
     MemoryService();
+    ~MemoryService();
     
-    ::std::string createGame(GameType type, Difficulty difficulty);
+    GameId createGame(GameType type, Difficulty difficulty);
     
-    ::std::shared_ptr<MemoryGame> getGame(const ::std::string& gameId);
+    ::std::shared_ptr<MemoryGame> getGame(const GameId& gameId);
     
-    void removeGame(const ::std::string& gameId);
+    void removeGame(const GameId& gameId);
     
     void cleanup();
+    
+    // Games not looked up for this long are reaped; 0 keeps them until deleted.
+    // Set before startReaper().
+    void setIdleTtl(GameType type, int seconds);
+    
+    // Background thread that every intervalMs reaps expired games from a slice
+    // of the registry shards, so a full sweep takes kReapSweepTicks ticks and no
+    // shard lock is held for more than kReapBatch removals at a time.
+    void startReaper(int intervalMs = 1000);
+    void stopReaper();
+    
+    // Background thread that keeps generated games ready for every game type
+    // and difficulty, so createGame only pops one and assigns its ID. Each
+    // pool's target is kReadySeconds of its smoothed create rate, between 1
+    // and maxReady; without the producer createGame generates in the request.
+    void startProducer(size_t maxReady = 64);
+    void stopProducer();
+    
+    GameStats stats() const;
 
 private:
-    ::std::unordered_map<::std::string, ::std::shared_ptr<MemoryGame>> games_;
-    ::std::mutex gamesMutex_;
-    ::std::string generateGameId();
+    static const size_t kReapSweepTicks = 10;
+    static const size_t kReapBatch = 64;
+    static const size_t kGameTypes = 3;
+    static const size_t kReadyPools = 6;   // sequence and cards, three difficulties each
+    static const int64_t kRateIntervalMs = 1000;
+    static constexpr double kReadySeconds = 1.0;
+    static constexpr double kRateSmoothing = 0.5;
+    
+    struct ReadyPool {
+        mutable ::std::mutex mutex;
+        GameType type = GameType::SEQUENCE;
+        Difficulty difficulty = Difficulty::MEDIUM;
+        ::std::vector<::std::shared_ptr<MemoryGame>> games;
+        size_t target = 1;
+        uint64_t requested = 0;            // creations since the last rate update
+        double rate = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        int64_t shortSinceMs = 0;          // when it fell below target; 0 while full
+        int64_t maxLagMs = 0;
+    };
+    
+    GamePool<SequenceGame> sequencePool_;
+    GamePool<CardPairsGame> cardPool_;
+    GameRegistry games_;
+    int64_t idleTtlMs_[kGameTypes];
+    size_t reapCursor_ = 0;               // next shard to sweep, reaper thread only
+    
+    ::std::atomic<uint64_t> created_{0};
+    ::std::atomic<uint64_t> deleted_{0};
+    ::std::atomic<uint64_t> expired_{0};
+    
+    ::std::thread reaper_;
+    ::std::atomic<bool> reaping_{false};
+    
+    ReadyPool readyPools_[kReadyPools];
+    size_t maxReady_ = 0;
+    ::std::thread producer_;
+    ::std::atomic<bool> producing_{false};
+    ::std::mutex producerMutex_;
+    ::std::condition_variable producerCv_;
+    bool refillWanted_ = false;           // guarded by producerMutex_
+    
+    // One reaper tick; returns how many games it evicted.
+    size_t reapExpired();
+    
+    // A fresh game from the slab pools, generated by the calling thread.
+    ::std::shared_ptr<MemoryGame> newGame(GameType type, Difficulty difficulty);
+    ::std::shared_ptr<MemoryGame> takeReady(GameType type, Difficulty difficulty);
+    // Tops every pool up to its target, one game per pool per round.
+    void refillReady();
+    void updateReadyTargets(int64_t elapsedMs);
 };
 
 }
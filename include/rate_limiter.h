@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "http_server.h"
+
+namespace SimpleHttp {
+
+struct RateLimit {
+    double requestsPerSecond = 0;          // 0 = unlimited
+    double burst = 0;
+};
+
+struct RateLimiterStats {
+    uint64_t allowed = 0;
+    uint64_t limited = 0;
+    uint64_t evicted = 0;
+    size_t capacity = 0;
+};
+
+// Token buckets keyed by client address and by session (sessionId query
+// parameter or X-Session-Id header), per route class. Buckets live in
+// fixed-size, set-associative shards updated with CAS only; when a set is full
+// the least recently used bucket is recycled, so memory never grows.
+// Classes and rules are configured before the server starts.
+class RateLimiter {
+public:
+    struct Decision {
+        bool allowed = true;
+        int retryAfterSeconds = 0;
+    };
+
+    explicit RateLimiter(size_t capacity = 64 * 1024);
+
+    void setClass(const ::std::string& name, RateLimit limit);
+    // pattern is an exact path or a prefix ending in '*'; an empty method matches any.
+    void assign(const ::std::string& method, const ::std::string& pattern, const ::std::string& className);
+
+    Decision check(const Request& req);
+    RateLimiterStats stats() const;
+
+private:
+    static const size_t kShards = 16;
+    static const size_t kWays = 8;
+
+    struct RouteClass {
+        ::std::string name;
+        RateLimit limit;
+    };
+
+    struct Rule {
+        ::std::string method;
+        ::std::string pattern;
+        bool prefix;
+        size_t classIndex;
+    };
+
+    struct Slot {
+        ::std::atomic<uint64_t> key{0};
+        ::std::atomic<uint64_t> state{0};  // last refill (ms, 32 bits) | tokens (16.16 fixed point)
+    };
+
+    struct alignas(64) Shard {
+        ::std::unique_ptr<Slot[]> slots;
+    };
+
+    const RouteClass* classify(const Request& req) const;
+    bool take(uint64_t key, const RateLimit& limit, uint32_t nowMs, int& retryAfterSeconds);
+
+    ::std::vector<RouteClass> classes_;
+    ::std::vector<Rule> rules_;
+    Shard shards_[kShards];
+    size_t setsPerShard_;
+
+    ::std::atomic<uint64_t> allowed_{0};
+    ::std::atomic<uint64_t> limited_{0};
+    ::std::atomic<uint64_t> evicted_{0};
+};
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "http_server.h"
+
+namespace SimpleHttp {
+
+class RouteParams {
+public:
+    static const size_t kMaxParams = 8;
+
+    ::std::string_view get(::std::string_view name) const;
+    int getInt(::std::string_view name, int fallback = 0) const;
+
+private:
+    friend class Router;
+
+    struct Param {
+        ::std::string_view name;
+        ::std::string_view value;
+    };
+
+    Param params_[kMaxParams];
+    size_t count_ = 0;
+};
+
+using RouteHandler = ::std::function<Response(const Request&, const RouteParams&)>;
+
+// Path trie built once at startup. Patterns are literal segments plus typed
+// parameters: "/api/game/{id}/flip" or "/api/items/{n:int}". Literal segments
+// win over parameters; paths that match a pattern but not the method get a 405.
+class Router {
+public:
+    Router();
+    ~Router();
+
+    void add(const ::std::string& method, const ::std::string& pattern, RouteHandler handler);
+    void get(const ::std::string& pattern, RouteHandler handler) { add("GET", pattern, ::std::move(handler)); }
+    void post(const ::std::string& pattern, RouteHandler handler) { add("POST", pattern, ::std::move(handler)); }
+    void del(const ::std::string& pattern, RouteHandler handler) { add("DELETE", pattern, ::std::move(handler)); }
+
+    // Called for paths that match no pattern at all (static files, custom 404s).
+    void setFallback(Handler handler) { fallback_ = ::std::move(handler); }
+
+    Response route(const Request& req) const;
+
+private:
+    enum class ParamType {
+        STRING,
+        INT
+    };
+
+    struct Node {
+        ::std::vector<::std::pair<::std::string, ::std::unique_ptr<Node>>> literals;
+        ::std::unique_ptr<Node> param;
+        ::std::string paramName;
+        ParamType paramType = ParamType::STRING;
+        ::std::vector<::std::pair<::std::string, RouteHandler>> handlers;
+    };
+
+    const Node* match(const Node* node, ::std::string_view path, RouteParams& params) const;
+
+    ::std::unique_ptr<Node> root_;
+    Handler fallback_;
+};
+
+}
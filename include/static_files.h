@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <ctime>
+
+#include "http_server.h"
+
+namespace SimpleHttp {
+
+struct StaticFile {
+    ::std::string filePath;
+    ::std::string contentType;
+    ::std::string etag;
+    ::std::string lastModified;
+    ::std::time_t mtime = 0;
+    size_t size = 0;
+    ::std::string content;      // empty for files streamed with sendfile
+    int fd = -1;
+    ::std::string gzipContent;  // empty when the type is not worth compressing
+    ::std::string gzipEtag;
+
+    ~StaticFile();
+};
+
+class StaticFileCache {
+public:
+    StaticFileCache(const ::std::string& root, size_t sendfileThreshold = 64 * 1024);
+    ~StaticFileCache();
+
+    static ::std::string resolveRoot(const ::std::vector<::std::string>& candidates);
+
+    void alias(const ::std::string& urlPath, const ::std::string& target);
+    void reload();
+    void watch(int intervalMs = 1000);
+
+    ::std::shared_ptr<const StaticFile> find(const ::std::string& urlPath) const;
+
+    // Fills res from the cache; returns false when the path is not a known asset.
+    bool serve(const Request& req, Response& res) const;
+
+    const ::std::string& root() const { return root_; }
+    size_t fileCount() const;
+
+private:
+    using Index = ::std::unordered_map<::std::string, ::std::shared_ptr<const StaticFile>>;
+
+    ::std::shared_ptr<const StaticFile> loadFile(const ::std::string& filePath,
+                                                 const ::std::shared_ptr<const StaticFile>& previous) const;
+    ::std::shared_ptr<const Index> snapshot() const;
+
+    ::std::string root_;
+    size_t sendfileThreshold_;
+    ::std::unordered_map<::std::string, ::std::string> aliases_;
+
+    ::std::shared_ptr<const Index> index_;
+    mutable ::std::mutex indexMutex_;
+
+    ::std::thread watcher_;
+    ::std::atomic<bool> watching_{false};
+};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SimpleHttp {
+
+// Intrusive timer handle, embedded in the object it times out.
+struct TimerNode {
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    uint64_t expiresTick = 0;
+    void* owner = nullptr;
+
+    bool scheduled() const { return next != nullptr; }
+};
+
+// Hierarchical timing wheel: four levels of 64 slots, each level 64 times
+// coarser than the one below. schedule() and cancel() are O(1); advance()
+// expires the current slot and cascades a coarser slot down whenever the finer
+// level wraps. Not thread-safe: every event loop owns its wheel.
+class TimerWheel {
+public:
+    TimerWheel(uint64_t nowMs, unsigned tickMs);
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // (Re)arms node to fire at deadlineMs, rounded up to the next tick.
+    void schedule(TimerNode& node, uint64_t deadlineMs);
+    void cancel(TimerNode& node);
+
+    // Moves time forward to nowMs and appends every node that fired to expired.
+    void advance(uint64_t nowMs, ::std::vector<TimerNode*>& expired);
+
+    size_t size() const { return size_; }
+    unsigned tickMs() const { return tickMs_; }
+
+private:
+    static const unsigned kLevels = 4;
+    static const unsigned kSlotBits = 6;
+    static const unsigned kSlots = 1u << kSlotBits;
+
+    void insert(TimerNode& node);
+    static void unlink(TimerNode& node);
+
+    TimerNode slots_[kLevels][kSlots];     // list heads
+    uint64_t currentTick_;
+    unsigned tickMs_;
+    size_t size_ = 0;
+};
+
+}
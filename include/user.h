@@ -6,11 +6,12 @@
 #include <vector>
 
 #include "memory_game.h"
+#include "ids.h"
 
 namespace MemoryTrainer {
 
 struct User {
-    ::std::string id;
+    UserId id;
     ::std::string username;
     ::std::string passwordHash;
     ::std::string email;
@@ -29,9 +30,9 @@ struct User {
 };
 
 struct GameSession {
-    ::std::string sessionId;
-    ::std::string userId;
-    ::std::string gameId;
+    SessionId sessionId;
+    UserId userId;
+    GameId gameId;
     GameType gameType;
     Difficulty difficulty;
     int score = 0;
@@ -41,7 +42,7 @@ struct GameSession {
 };
 
 struct LeaderboardEntry {
-    ::std::string userId;
+    UserId userId;
     ::std::string username;
     int totalScore;
     int gamesWon;
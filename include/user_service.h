@@ -10,6 +10,7 @@
 
 #include "user.h"
 #include "memory_game.h"
+#include "ids.h"
 
 namespace MemoryTrainer {
 
@@ -18,15 +19,16 @@ public:
     UserService();
     ~UserService();
     
-    ::std::string registerUser(const ::std::string& username, const ::std::string& email, const ::std::string& password);
-    ::std::string loginUser(const ::std::string& username, const ::std::string& password);
-    bool logoutUser(const ::std::string& sessionId);
+    // Empty IDs mean the username or email is taken, or the password is wrong.
+    UserId registerUser(const ::std::string& username, const ::std::string& email, const ::std::string& password);
+    SessionId loginUser(const ::std::string& username, const ::std::string& password);
+    bool logoutUser(const SessionId& sessionId);
     
-    ::std::shared_ptr<User> getUserById(const ::std::string& userId);
-    ::std::shared_ptr<User> getUserBySession(const ::std::string& sessionId);
+    ::std::shared_ptr<User> getUserById(const UserId& userId);
+    ::std::shared_ptr<User> getUserBySession(const SessionId& sessionId);
     ::std::shared_ptr<User> getUserByUsername(const ::std::string& username);
     
-    void updateUserStats(const ::std::string& userId, int score, bool won);
+    void updateUserStats(const UserId& userId, int score, bool won);
     
     ::std::vector<LeaderboardEntry> getLeaderboard(int limit = 10);
     
@@ -34,13 +36,11 @@ public:
     void loadUsers();
 
 private:
-    ::std::unordered_map<::std::string, ::std::shared_ptr<User>> users_;
-    ::std::unordered_map<::std::string, ::std::string> sessions_; 
+    ::std::unordered_map<UserId, ::std::shared_ptr<User>, IdHash> users_;
+    ::std::unordered_map<SessionId, UserId, IdHash> sessions_;
     ::std::mutex usersMutex_;
     ::std::string dataFile_ = "users.dat";
     
-    ::std::string generateUserId();
-    ::std::string generateSessionId();
     ::std::string hashPassword(const ::std::string& password);
     bool verifyPassword(const ::std::string& password, const ::std::string& hash);
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include "http_server.h"
+
+namespace SimpleHttp {
+
+// Receives the messages of one upgraded connection, always on the thread that
+// owns the connection. The reply, if not empty, goes back as a text frame.
+class WebSocketHandler {
+public:
+    virtual ~WebSocketHandler() = default;
+    virtual ::std::string onMessage(::std::string_view message) = 0;
+};
+
+// Turns res into the 101 handshake for a valid upgrade request (400/426 otherwise);
+// once it has been written the server hands every message on the connection to handler.
+bool acceptWebSocket(const Request& req, Response& res, ::std::shared_ptr<WebSocketHandler> handler);
+
+enum class WebSocketOpcode : uint8_t {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+};
+
+struct WebSocketFrame {
+    WebSocketOpcode opcode = WebSocketOpcode::TEXT;
+    bool fin = true;
+    char* payload = nullptr;               // unmasked in place inside the connection buffer
+    size_t payloadSize = 0;
+};
+
+// Parses one client frame (RFC 6455, masked, no extensions) at data.
+class WebSocketFrameParser {
+public:
+    enum class Status {
+        INCOMPLETE,
+        COMPLETE,
+        PROTOCOL_ERROR,
+        TOO_LARGE
+    };
+
+    explicit WebSocketFrameParser(size_t maxPayload) : maxPayload_(maxPayload) {}
+
+    // On COMPLETE, frameSize() bytes at data belong to frame.
+    Status parse(char* data, size_t size, WebSocketFrame& frame);
+    size_t frameSize() const { return frameSize_; }
+
+private:
+    size_t maxPayload_;
+    size_t frameSize_ = 0;
+};
+
+// Server frames are never masked, so the header is all that has to be built.
+::std::string webSocketFrameHeader(WebSocketOpcode opcode, size_t payloadSize);
+
+// Close payload: status code in network byte order.
+::std::string webSocketClosePayload(uint16_t statusCode);
+
+}
@@ -2,66 +2,128 @@
 #include "memory_service.h"
 #include "user_service.h"
 #include "card_pairs_game.h"
-#include <sstream>
+#include "json_writer.h"
+#include "compression.h"
 #include <iostream>
-#include <regex>
-
-namespace SimpleJson {
-    ::std::string object(const ::std::vector<::std::pair<::std::string, ::std::string>>& fields) {
-        ::std::ostringstream oss;
-        oss << "{";
-        for (size_t i = 0; i < fields.size(); ++i) {
-            if (i > 0) oss << ",";
-            oss << "\"" << fields[i].first << "\":";
-            ::std::string value = fields[i].second;
-            
-            if (!value.empty() && (value[0] == '{' || value[0] == '[')) {
-                oss << value;
-            } else if (value == "true" || value == "false") {
-                oss << value;
-            } else {
-                oss << "\"";
-                for (char c : value) {
-                    if (c == '"') oss << "\\\"";
-                    else if (c == '\\') oss << "\\\\";
-                    else if (c == '\n') oss << "\\n";
-                    else if (c == '\r') oss << "\\r";
-                    else if (c == '\t') oss << "\\t";
-                    else oss << c;
-                }
-                oss << "\"";
-            }
-        }
-        oss << "}";
-        return oss.str();
-    }
-    
-    ::std::string array(const ::std::vector<int>& values) {
-        ::std::ostringstream oss;
-        oss << "[";
-        for (size_t i = 0; i < values.size(); ++i) {
-            oss << values[i];
-            if (i < values.size() - 1) oss << ",";
+#include <string_view>
+
+namespace {
+
+using SimpleJson::Writer;
+
+::std::string errorJson(::std::string_view message) {
+    ::std::string body;
+    Writer(body).beginObject().field("error", message).endObject();
+    return body;
+}
+
+void writeCard(Writer& json, const MemoryTrainer::Card& card) {
+    json.beginObject()
+        .field("id", card.id)
+        .field("value", card.value)
+        .field("flipped", card.flipped)
+        .field("matched", card.matched)
+        .endObject();
+}
+
+void writeCards(Writer& json, const ::std::vector<MemoryTrainer::Card>& cards) {
+    json.beginArray();
+    for (const auto& card : cards) {
+        writeCard(json, card);
+    }
+    json.endArray();
+}
+
+// "version" plus either "changedCards" (cards changed after since) or the full
+// "cards" list when no delta was asked for or since is not a version of this deal.
+void writeCardState(Writer& json, const MemoryTrainer::CardPairsGame& game, int64_t since) {
+    json.field("version", game.getVersion());
+    if (since < 0) {
+        json.key("cards");
+        writeCards(json, game.getCards());
+        return;
+    }
+
+    uint64_t base = static_cast<uint64_t>(since);
+    if (!game.hasChangesSince(base)) {
+        json.field("delta", false).key("cards");
+        writeCards(json, game.getCards());
+        return;
+    }
+    json.field("delta", true).key("changedCards").beginArray();
+    for (const auto& card : game.getCards()) {
+        if (card.version > base) {
+            writeCard(json, card);
         }
-        oss << "]";
-        return oss.str();
-    }
-    
-    ::std::string escape(const ::std::string& str) {
-        ::std::ostringstream oss;
-        for (char c : str) {
-            if (c == '"') oss << "\\\"";
-            else if (c == '\\') oss << "\\\\";
-            else if (c == '\n') oss << "\\n";
-            else oss << c;
+    }
+    json.endArray();
+}
+
+void writeFlippedCards(Writer& json, const MemoryTrainer::CardPairsGame& game) {
+    auto flippedPair = game.getFlippedCards();
+    json.beginArray();
+    if (flippedPair.first >= 0) {
+        json.value(flippedPair.first);
+        if (flippedPair.second >= 0) {
+            json.value(flippedPair.second);
         }
-        return oss.str();
     }
+    json.endArray();
+}
+
+const char* typeName(MemoryTrainer::GameType type) {
+    if (type == MemoryTrainer::GameType::PAIRS) return "cards";
+    if (type == MemoryTrainer::GameType::NUMBERS) return "numbers";
+    return "sequence";
+}
+
+const char* difficultyName(MemoryTrainer::Difficulty difficulty) {
+    if (difficulty == MemoryTrainer::Difficulty::EASY) return "easy";
+    if (difficulty == MemoryTrainer::Difficulty::HARD) return "hard";
+    return "medium";
+}
+
+const char* pairMessage(bool gameComplete, bool isPair) {
+    if (gameComplete) return "Поздравляем! Все пары найдены!";
+    return isPair ? "Пара найдена!" : "Не пара, попробуйте еще раз";
+}
+
+// The GET /api/game/{id} body; returns the state version it shows.
+uint64_t writeGame(::std::string& body, const ::std::string& gameId, MemoryTrainer::MemoryGame& game, int64_t since) {
+    Writer json(body);
+
+    if (auto cardGame = dynamic_cast<MemoryTrainer::CardPairsGame*>(&game)) {
+        ::std::lock_guard<::std::mutex> lock(cardGame->mutex());
+        body.reserve(cardGame->getCards().size() * 56 + 160);
+        json.beginObject()
+            .field("gameId", gameId)
+            .field("type", "cards")
+            .field("difficulty", difficultyName(game.getDifficulty()));
+        writeCardState(json, *cardGame, since);
+        json.field("moves", cardGame->getMovesCount())
+            .field("pairsFound", cardGame->getPairsFound())
+            .field("isComplete", cardGame->isGameComplete())
+            .endObject();
+        return cardGame->getVersion();
+    }
+
+    auto sequence = game.getSequence();
+
+    json.beginObject()
+        .field("gameId", gameId)
+        .field("type", typeName(game.getType()))
+        .field("difficulty", difficultyName(game.getDifficulty()))
+        .key("sequence").array(sequence.data(), sequence.size())
+        .field("memorizationTime", game.getMemorizationTime())
+        .endObject();
+    return game.getStateVersion();
+}
+
 }
 
 namespace MemoryTrainer {
 
-ApiController::ApiController(MemoryService& service, UserService& userService) 
+ApiController::ApiController(MemoryService& service, UserService& userService)
     : service_(service), userService_(userService) {
 }
 
@@ -69,371 +131,460 @@ ApiController::ApiController(MemoryService& service, UserService& userService)
     GameType gameType = GameType::SEQUENCE;
     if (type == "pairs" || type == "cards") gameType = GameType::PAIRS;
     else if (type == "numbers") gameType = GameType::NUMBERS;
-    
+
     Difficulty diff = Difficulty::MEDIUM;
     if (difficulty == "easy") diff = Difficulty::EASY;
     else if (difficulty == "hard") diff = Difficulty::HARD;
-    
-    ::std::string gameId = service_.createGame(gameType, diff);
-    auto game = service_.getGame(gameId);
-    
+
+    GameId id = service_.createGame(gameType, diff);
+    auto game = service_.getGame(id);
+
     if (!game) {
-        return SimpleJson::object({
-            {"error", "Failed to create game"}
-        });
+        return errorJson("Failed to create game");
     }
-    
+    ::std::string gameId = id.toString();
+
+    ::std::string body;
+    Writer json(body);
+
     if (gameType == GameType::PAIRS) {
         auto cardGame = ::std::dynamic_pointer_cast<CardPairsGame>(game);
         if (cardGame) {
-            auto cards = cardGame->getCards();
-            ::std::ostringstream cardsJson;
-            cardsJson << "[";
-            for (size_t i = 0; i < cards.size(); ++i) {
-                if (i > 0) cardsJson << ",";
-                cardsJson << "{";
-                cardsJson << "\"id\":" << cards[i].id << ",";
-                cardsJson << "\"value\":" << cards[i].value << ",";
-                cardsJson << "\"flipped\":" << (cards[i].flipped ? "true" : "false") << ",";
-                cardsJson << "\"matched\":" << (cards[i].matched ? "true" : "false");
-                cardsJson << "}";
-            }
-            cardsJson << "]";
-            
-            ::std::string cardsJsonStr = cardsJson.str();
-            
-            return SimpleJson::object({
-                {"gameId", gameId},
-                {"type", "cards"},
-                {"difficulty", difficulty},
-                {"cards", cardsJsonStr},
-                {"totalPairs", ::std::to_string(static_cast<int>(cards.size()) / 2)}
-            });
+            const auto& cards = cardGame->getCards();
+            body.reserve(cards.size() * 56 + 128);
+            json.beginObject()
+                .field("gameId", gameId)
+                .field("type", "cards")
+                .field("difficulty", difficulty)
+                .key("cards");
+            writeCards(json, cards);
+            json.field("totalPairs", static_cast<int>(cards.size()) / 2)
+                .endObject();
+            return body;
         }
     }
-    
+
     auto sequence = game->getSequence();
-    
-    return SimpleJson::object({
-        {"gameId", gameId},
-        {"type", type},
-        {"difficulty", difficulty},
-        {"sequence", SimpleJson::array(sequence)},
-        {"memorizationTime", ::std::to_string(game->getMemorizationTime())}
-    });
+
+    json.beginObject()
+        .field("gameId", gameId)
+        .field("type", type)
+        .field("difficulty", difficulty)
+        .key("sequence").array(sequence.data(), sequence.size())
+        .field("memorizationTime", game->getMemorizationTime())
+        .endObject();
+    return body;
 }
 
-::std::string ApiController::handleGetGame(const ::std::string& gameId) {
-    auto game = service_.getGame(gameId);
-    
+::std::string ApiController::handleGetGame(const ::std::string& gameId, int64_t since) {
+    auto game = findGame(gameId);
+
     if (!game) {
-        return SimpleJson::object({
-            {"error", "Game not found"}
-        });
-    }
-    
-    ::std::string typeStr = "sequence";
-    if (game->getType() == GameType::PAIRS) typeStr = "cards";
-    else if (game->getType() == GameType::NUMBERS) typeStr = "numbers";
-    
-    ::std::string diffStr = "medium";
-    if (game->getDifficulty() == Difficulty::EASY) diffStr = "easy";
-    else if (game->getDifficulty() == Difficulty::HARD) diffStr = "hard";
-    
-    if (game->getType() == GameType::PAIRS) {
-        auto cardGame = ::std::dynamic_pointer_cast<CardPairsGame>(game);
-        if (cardGame) {
-            auto cards = cardGame->getCards();
-            ::std::ostringstream cardsJson;
-            cardsJson << "[";
-            for (size_t i = 0; i < cards.size(); ++i) {
-                if (i > 0) cardsJson << ",";
-                cardsJson << "{";
-                cardsJson << "\"id\":" << cards[i].id << ",";
-                cardsJson << "\"value\":" << cards[i].value << ",";
-                cardsJson << "\"flipped\":" << (cards[i].flipped ? "true" : "false") << ",";
-                cardsJson << "\"matched\":" << (cards[i].matched ? "true" : "false");
-                cardsJson << "}";
-            }
-            cardsJson << "]";
-            
-            return SimpleJson::object({
-                {"gameId", gameId},
-                {"type", "cards"},
-                {"difficulty", diffStr},
-                {"cards", cardsJson.str()},
-                {"moves", ::std::to_string(cardGame->getMovesCount())},
-                {"pairsFound", ::std::to_string(cardGame->getPairsFound())},
-                {"isComplete", cardGame->isGameComplete() ? "true" : "false"}
-            });
+        return errorJson("Game not found");
+    }
+
+    ::std::string body;
+    writeGame(body, gameId, *game, since);
+    return body;
+}
+
+::std::shared_ptr<const GameSnapshot> ApiController::handleGetGameSnapshot(const ::std::string& gameId, int gzipLevel, size_t gzipMinSize) {
+    auto game = findGame(gameId);
+    if (!game) {
+        return nullptr;
+    }
+
+    SimpleJson::Format format = Writer::currentFormat();
+    size_t slot = static_cast<size_t>(format);
+    auto cached = game->getSnapshot(slot);
+    if (cached && cached->version == game->getStateVersion()) {
+        return cached;
+    }
+
+    auto snapshot = ::std::make_shared<GameSnapshot>();
+    snapshot->version = writeGame(snapshot->body, gameId, *game, -1);
+    snapshot->etag = "\"" + ::std::to_string(snapshot->version) +
+                     (format == SimpleJson::Format::CBOR ? "-cbor\"" : "-json\"");
+    if (gzipLevel > 0 && snapshot->body.size() >= gzipMinSize) {
+        ::std::string gz = SimpleHttp::gzipCompress(snapshot->body, gzipLevel);
+        if (!gz.empty() && gz.size() < snapshot->body.size()) {
+            snapshot->gzipBody = ::std::move(gz);
+            snapshot->gzipEtag = snapshot->etag.substr(0, snapshot->etag.size() - 1) + "-gz\"";
         }
     }
-    
-    auto sequence = game->getSequence();
-    
-    return SimpleJson::object({
-        {"gameId", gameId},
-        {"type", typeStr},
-        {"difficulty", diffStr},
-        {"sequence", SimpleJson::array(sequence)},
-        {"memorizationTime", ::std::to_string(game->getMemorizationTime())}
-    });
+    game->setSnapshot(slot, snapshot);
+    return snapshot;
 }
 
 ::std::string ApiController::handleCheckAnswer(const ::std::string& gameId, const ::std::vector<int>& answer, const ::std::string& sessionId) {
-    auto game = service_.getGame(gameId);
-    
+    auto game = findGame(gameId);
+
     if (!game) {
-        return SimpleJson::object({
-            {"error", "Game not found"}
-        });
+        return errorJson("Game not found");
     }
-    
+
     auto result = game->checkAnswer(answer);
-    
+
     if (!sessionId.empty()) {
-        auto user = userService_.getUserBySession(sessionId);
+        auto user = findSessionUser(sessionId);
         if (user) {
             userService_.updateUserStats(user->id, result.score, result.success);
         }
     }
-    
-    return SimpleJson::object({
-        {"success", result.success ? "true" : "false"},
-        {"score", ::std::to_string(result.score)},
-        {"message", result.message}
-    });
+
+    ::std::string body;
+    Writer(body).beginObject()
+        .field("success", result.success)
+        .field("score", result.score)
+        .field("message", result.message)
+        .endObject();
+    return body;
 }
 
-::std::string ApiController::handleFlipCard(const ::std::string& gameId, int cardId) {
-    auto game = service_.getGame(gameId);
-    
-    if (!game || game->getType() != GameType::PAIRS) {
-        return SimpleJson::object({
-            {"error", "Game not found or invalid type"}
-        });
+::std::string ApiController::handleFlipCard(const ::std::string& gameId, int cardId, int64_t since) {
+    auto cardGame = findCardGame(gameId);
+    if (!cardGame) {
+        return errorJson("Game not found or invalid type");
+    }
+
+    ::std::lock_guard<::std::mutex> lock(cardGame->mutex());
+    if (!cardGame->flipCard(cardId)) {
+        return errorJson("Cannot flip card");
     }
-    
-    auto cardGame = ::std::dynamic_pointer_cast<CardPairsGame>(game);
+
+    const auto& cards = cardGame->getCards();
+    ::std::string body;
+    body.reserve(cards.size() * 56 + 128);
+    Writer json(body);
+    json.beginObject()
+        .field("success", true);
+    writeCardState(json, *cardGame, since);
+    json.key("flippedCards");
+    writeFlippedCards(json, *cardGame);
+    json.field("moves", cardGame->getMovesCount())
+        .field("pairsFound", cardGame->getPairsFound())
+        .field("isComplete", cardGame->isGameComplete())
+        .endObject();
+    return body;
+}
+
+::std::string ApiController::handleCheckCardPair(const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId, int64_t since) {
+    auto cardGame = findCardGame(gameId);
     if (!cardGame) {
-        return SimpleJson::object({
-            {"error", "Invalid game type"}
-        });
-    }
-    
-    bool flipped = cardGame->flipCard(cardId);
-    if (!flipped) {
-        return SimpleJson::object({
-            {"error", "Cannot flip card"}
-        });
-    }
-    
-    auto cards = cardGame->getCards();
-    auto flippedPair = cardGame->getFlippedCards();
-    
-    ::std::ostringstream cardsJson;
-    cardsJson << "[";
-    for (size_t i = 0; i < cards.size(); ++i) {
-        cardsJson << "{";
-        cardsJson << "\"id\":" << cards[i].id << ",";
-        cardsJson << "\"value\":" << cards[i].value << ",";
-        cardsJson << "\"flipped\":" << (cards[i].flipped ? "true" : "false") << ",";
-        cardsJson << "\"matched\":" << (cards[i].matched ? "true" : "false");
-        cardsJson << "}";
-        if (i < cards.size() - 1) cardsJson << ",";
-    }
-    cardsJson << "]";
-    
-    ::std::ostringstream flippedJson;
-    flippedJson << "[";
-    if (flippedPair.first >= 0) {
-        flippedJson << flippedPair.first;
-        if (flippedPair.second >= 0) {
-            flippedJson << "," << flippedPair.second;
-        }
+        return errorJson("Game not found or invalid type");
     }
-    flippedJson << "]";
-    
-    return SimpleJson::object({
-        {"success", "true"},
-        {"cards", cardsJson.str()},
-        {"flippedCards", flippedJson.str()},
-        {"moves", ::std::to_string(cardGame->getMovesCount())},
-        {"pairsFound", ::std::to_string(cardGame->getPairsFound())},
-        {"isComplete", cardGame->isGameComplete() ? "true" : "false"}
-    });
+
+    ::std::lock_guard<::std::mutex> lock(cardGame->mutex());
+    bool wasComplete = cardGame->isGameComplete();
+    bool isPair = cardGame->checkPair(cardId1, cardId2);
+    cardGame->resetFlippedCards();
+
+    // Only the move that completes the game is scored and credited.
+    bool gameComplete = cardGame->isGameComplete();
+    int score = gameComplete && !wasComplete ? finishCardGame(*cardGame, sessionId) : 0;
+
+    const auto& cards = cardGame->getCards();
+    ::std::string body;
+    body.reserve(cards.size() * 56 + 256);
+    Writer json(body);
+    json.beginObject()
+        .field("isPair", isPair);
+    writeCardState(json, *cardGame, since);
+    json.key("flippedCards").beginArray().endArray()
+        .field("moves", cardGame->getMovesCount())
+        .field("pairsFound", cardGame->getPairsFound())
+        .field("isComplete", gameComplete)
+        .field("score", score)
+        .field("message", pairMessage(gameComplete, isPair))
+        .endObject();
+    return body;
 }
 
-::std::string ApiController::handleCheckCardPair(const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId) {
-    auto game = service_.getGame(gameId);
-    
+::std::shared_ptr<MemoryGame> ApiController::findGame(const ::std::string& gameId) {
+    GameId id;
+    return GameId::parse(gameId, id) ? service_.getGame(id) : nullptr;
+}
+
+::std::shared_ptr<CardPairsGame> ApiController::findCardGame(const ::std::string& gameId) {
+    auto game = findGame(gameId);
     if (!game || game->getType() != GameType::PAIRS) {
-        return SimpleJson::object({
-            {"error", "Game not found or invalid type"}
-        });
+        return nullptr;
+    }
+    return ::std::dynamic_pointer_cast<CardPairsGame>(game);
+}
+
+::std::shared_ptr<User> ApiController::findSessionUser(const ::std::string& sessionId) {
+    SessionId id;
+    return SessionId::parse(sessionId, id) ? userService_.getUserBySession(id) : nullptr;
+}
+
+// Scores a completed card game and credits it to the session's user, if any.
+int ApiController::finishCardGame(CardPairsGame& game, const ::std::string& sessionId) {
+    int score = game.checkAnswer({}).score;
+    if (!sessionId.empty()) {
+        auto user = findSessionUser(sessionId);
+        if (user) {
+            userService_.updateUserStats(user->id, score, true);
+        }
     }
-    
-    auto cardGame = ::std::dynamic_pointer_cast<CardPairsGame>(game);
+    return score;
+}
+
+::std::string ApiController::handleFlipCardUpdate(const ::std::string& gameId, int cardId) {
+    ::std::string body;
+    Writer json(body);
+
+    auto cardGame = findCardGame(gameId);
     if (!cardGame) {
-        return SimpleJson::object({
-            {"error", "Invalid game type"}
-        });
+        json.beginObject()
+            .field("type", "error")
+            .field("error", "Game not found or invalid type")
+            .endObject();
+        return body;
+    }
+
+    ::std::lock_guard<::std::mutex> lock(cardGame->mutex());
+    if (!cardGame->flipCard(cardId)) {
+        json.beginObject()
+            .field("type", "error")
+            .field("cardId", cardId)
+            .field("error", "Cannot flip card")
+            .endObject();
+        return body;
+    }
+
+    int value = 0;
+    for (const auto& card : cardGame->getCards()) {
+        if (card.id == cardId) {
+            value = card.value;
+            break;
+        }
     }
-    
+
+    json.beginObject()
+        .field("type", "flip")
+        .field("version", cardGame->getVersion())
+        .field("cardId", cardId)
+        .field("value", value)
+        .key("flippedCards");
+    writeFlippedCards(json, *cardGame);
+    json.endObject();
+    return body;
+}
+
+::std::string ApiController::handleCheckCardPairUpdate(const ::std::string& gameId, int cardId1, int cardId2, const ::std::string& sessionId) {
+    ::std::string body;
+    Writer json(body);
+
+    auto cardGame = findCardGame(gameId);
+    if (!cardGame) {
+        json.beginObject()
+            .field("type", "error")
+            .field("error", "Game not found or invalid type")
+            .endObject();
+        return body;
+    }
+
+    ::std::lock_guard<::std::mutex> lock(cardGame->mutex());
+    bool wasComplete = cardGame->isGameComplete();
     bool isPair = cardGame->checkPair(cardId1, cardId2);
-    
     cardGame->resetFlippedCards();
 
-    auto cards = cardGame->getCards();
-    ::std::ostringstream cardsJson;
-    cardsJson << "[";
-    for (size_t i = 0; i < cards.size(); ++i) {
-        if (i > 0) cardsJson << ",";
-        cardsJson << "{";
-        cardsJson << "\"id\":" << cards[i].id << ",";
-        cardsJson << "\"value\":" << cards[i].value << ",";
-        cardsJson << "\"flipped\":" << (cards[i].flipped ? "true" : "false") << ",";
-        cardsJson << "\"matched\":" << (cards[i].matched ? "true" : "false");
-        cardsJson << "}";
-    }
-    cardsJson << "]";
-    
-    ::std::string flippedJson = "[]";
-    
+    // Only the move that completes the game is scored and credited.
     bool gameComplete = cardGame->isGameComplete();
-    int score = 0;
-    
-    if (gameComplete) {
-        auto result = cardGame->checkAnswer({});
-        score = result.score;
-        
-        if (!sessionId.empty()) {
-            auto user = userService_.getUserBySession(sessionId);
-            if (user) {
-                userService_.updateUserStats(user->id, score, true);
+    int score = gameComplete && !wasComplete ? finishCardGame(*cardGame, sessionId) : 0;
+
+    json.beginObject()
+        .field("type", "pair")
+        .field("version", cardGame->getVersion())
+        .field("cardId1", cardId1)
+        .field("cardId2", cardId2)
+        .field("isPair", isPair)
+        .field("moves", cardGame->getMovesCount())
+        .field("pairsFound", cardGame->getPairsFound())
+        .field("isComplete", gameComplete)
+        .field("score", score)
+        .field("message", pairMessage(gameComplete, isPair))
+        .endObject();
+    return body;
+}
+
+// All moves run under one acquisition of the game lock, so no other client's
+// move can land between them; a move that fails leaves the game unchanged.
+::std::string ApiController::handleCardMoves(const ::std::string& gameId, const ::std::vector<CardMove>& moves, const ::std::string& sessionId, int64_t since) {
+    auto cardGame = findCardGame(gameId);
+    if (!cardGame) {
+        return errorJson("Game not found or invalid type");
+    }
+
+    ::std::lock_guard<::std::mutex> lock(cardGame->mutex());
+    bool wasComplete = cardGame->isGameComplete();
+
+    const auto& cards = cardGame->getCards();
+    ::std::string body;
+    body.reserve(moves.size() * 72 + cards.size() * 56 + 160);
+    Writer json(body);
+    json.beginObject().key("results").beginArray();
+    for (const CardMove& move : moves) {
+        if (move.kind == CardMove::Kind::FLIP) {
+            json.beginObject()
+                .field("type", "flip")
+                .field("cardId", move.cardId1)
+                .field("success", cardGame->flipCard(move.cardId1))
+                .endObject();
+        } else {
+            int movesBefore = cardGame->getMovesCount();
+            bool isPair = cardGame->checkPair(move.cardId1, move.cardId2);
+            bool applied = cardGame->getMovesCount() != movesBefore;
+            if (applied) {
+                cardGame->resetFlippedCards();
             }
+            json.beginObject()
+                .field("type", "check-pair")
+                .field("cardId1", move.cardId1)
+                .field("cardId2", move.cardId2)
+                .field("success", applied)
+                .field("isPair", isPair)
+                .endObject();
         }
     }
-    
-    return SimpleJson::object({
-        {"isPair", isPair ? "true" : "false"},
-        {"cards", cardsJson.str()},
-        {"flippedCards", flippedJson},
-        {"moves", ::std::to_string(cardGame->getMovesCount())},
-        {"pairsFound", ::std::to_string(cardGame->getPairsFound())},
-        {"isComplete", gameComplete ? "true" : "false"},
-        {"score", ::std::to_string(score)},
-        {"message", gameComplete ? "Поздравляем! Все пары найдены!" : (isPair ? "Пара найдена!" : "Не пара, попробуйте еще раз")}
-    });
+    json.endArray();
+
+    // Only the batch that completes the game is scored and credited.
+    bool gameComplete = cardGame->isGameComplete();
+    int score = gameComplete && !wasComplete ? finishCardGame(*cardGame, sessionId) : 0;
+
+    writeCardState(json, *cardGame, since);
+    json.key("flippedCards");
+    writeFlippedCards(json, *cardGame);
+    json.field("moves", cardGame->getMovesCount())
+        .field("pairsFound", cardGame->getPairsFound())
+        .field("isComplete", gameComplete)
+        .field("score", score)
+        .endObject();
+    return body;
 }
 
 ::std::string ApiController::handleRegister(const ::std::string& username, const ::std::string& email, const ::std::string& password) {
     if (username.empty() || email.empty() || password.empty()) {
-        return SimpleJson::object({
-            {"error", "All fields are required"}
-        });
+        return errorJson("All fields are required");
     }
-    
-    ::std::string userId = userService_.registerUser(username, email, password);
-    
+
+    UserId userId = userService_.registerUser(username, email, password);
+
     if (userId.empty()) {
-        return SimpleJson::object({
-            {"error", "Username or email already exists"}
-        });
-    }
-    
-    return SimpleJson::object({
-        {"success", "true"},
-        {"userId", userId},
-        {"message", "User registered successfully"}
-    });
+        return errorJson("Username or email already exists");
+    }
+
+    ::std::string body;
+    Writer(body).beginObject()
+        .field("success", true)
+        .field("userId", userId.toString())
+        .field("message", "User registered successfully")
+        .endObject();
+    return body;
 }
 
 ::std::string ApiController::handleLogin(const ::std::string& username, const ::std::string& password) {
-    ::std::string sessionId = userService_.loginUser(username, password);
-    
+    ::std::string body;
+    Writer json(body);
+    SessionId sessionId = userService_.loginUser(username, password);
+
     if (sessionId.empty()) {
-        return SimpleJson::object({
-            {"success", "false"},
-            {"error", "Invalid username or password"}
-        });
+        json.beginObject()
+            .field("success", false)
+            .field("error", "Invalid username or password")
+            .endObject();
+        return body;
     }
-    
+
     auto user = userService_.getUserBySession(sessionId);
     if (!user) {
-        return SimpleJson::object({
-            {"success", "false"},
-            {"error", "Failed to get user data"}
-        });
-    }
-    
-    return SimpleJson::object({
-        {"success", "true"},
-        {"sessionId", sessionId},
-        {"username", user->username},
-        {"totalScore", ::std::to_string(user->totalScore)},
-        {"gamesPlayed", ::std::to_string(user->gamesPlayed)},
-        {"gamesWon", ::std::to_string(user->gamesWon)}
-    });
+        json.beginObject()
+            .field("success", false)
+            .field("error", "Failed to get user data")
+            .endObject();
+        return body;
+    }
+
+    json.beginObject()
+        .field("success", true)
+        .field("sessionId", sessionId.toString())
+        .field("username", user->username)
+        .field("totalScore", user->totalScore)
+        .field("gamesPlayed", user->gamesPlayed)
+        .field("gamesWon", user->gamesWon)
+        .endObject();
+    return body;
 }
 
 ::std::string ApiController::handleLogout(const ::std::string& sessionId) {
-    bool success = userService_.logoutUser(sessionId);
-    return SimpleJson::object({
-        {"success", success ? "true" : "false"}
-    });
+    SessionId id;
+    bool success = SessionId::parse(sessionId, id) && userService_.logoutUser(id);
+    ::std::string body;
+    Writer(body).beginObject().field("success", success).endObject();
+    return body;
 }
 
 ::std::string ApiController::handleGetUser(const ::std::string& sessionId) {
-    auto user = userService_.getUserBySession(sessionId);
-    
+    ::std::string body;
+    Writer json(body);
+    auto user = findSessionUser(sessionId);
+
     if (!user) {
-        return SimpleJson::object({
-            {"success", "false"},
-            {"error", "User not found or session expired"}
-        });
-    }
-    
-    return SimpleJson::object({
-        {"success", "true"},
-        {"user", SimpleJson::object({
-            {"userId", user->id},
-            {"username", user->username},
-            {"email", user->email},
-            {"totalScore", ::std::to_string(user->totalScore)},
-            {"gamesPlayed", ::std::to_string(user->gamesPlayed)},
-            {"gamesWon", ::std::to_string(user->gamesWon)},
-            {"winRate", ::std::to_string(user->gamesPlayed > 0 ? 
-                (static_cast<double>(user->gamesWon) / user->gamesPlayed * 100.0) : 0.0)}
-        })}
-    });
+        json.beginObject()
+            .field("success", false)
+            .field("error", "User not found or session expired")
+            .endObject();
+        return body;
+    }
+
+    double winRate = user->gamesPlayed > 0 ?
+        static_cast<double>(user->gamesWon) / user->gamesPlayed * 100.0 : 0.0;
+
+    json.beginObject()
+        .field("success", true)
+        .key("user").beginObject()
+            .field("userId", user->id.toString())
+            .field("username", user->username)
+            .field("email", user->email)
+            .field("totalScore", user->totalScore)
+            .field("gamesPlayed", user->gamesPlayed)
+            .field("gamesWon", user->gamesWon)
+            .field("winRate", winRate)
+        .endObject()
+        .endObject();
+    return body;
 }
 
 ::std::string ApiController::handleGetLeaderboard(int limit) {
     auto entries = userService_.getLeaderboard(limit);
-    
-    ::std::ostringstream oss;
-    oss << "[";
-    for (size_t i = 0; i < entries.size(); ++i) {
-        oss << "{";
-        oss << "\"rank\":" << entries[i].rank << ",";
-        oss << "\"username\":\"" << SimpleJson::escape(entries[i].username) << "\",";
-        oss << "\"totalScore\":" << entries[i].totalScore << ",";
-        oss << "\"gamesWon\":" << entries[i].gamesWon << ",";
-        oss << "\"winRate\":" << entries[i].winRate;
-        oss << "}";
-        if (i < entries.size() - 1) oss << ",";
-    }
-    oss << "]";
-    
-    return oss.str();
+
+    ::std::string body;
+    body.reserve(entries.size() * 96 + 2);
+    Writer json(body);
+    json.beginArray();
+    for (const auto& entry : entries) {
+        json.beginObject()
+            .field("rank", entry.rank)
+            .field("username", entry.username)
+            .field("totalScore", entry.totalScore)
+            .field("gamesWon", entry.gamesWon)
+            .field("winRate", entry.winRate)
+            .endObject();
+    }
+    json.endArray();
+    return body;
 }
 
 ::std::string ApiController::handleDeleteGame(const ::std::string& gameId) {
-    service_.removeGame(gameId);
-    return SimpleJson::object({
-        {"status", "deleted"}
-    });
+    GameId id;
+    if (GameId::parse(gameId, id)) {
+        service_.removeGame(id);
+    }
+    ::std::string body;
+    Writer(body).beginObject().field("status", "deleted").endObject();
+    return body;
 }
 
 }
@@ -0,0 +1,70 @@
+#include "arena.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace SimpleHttp {
+
+thread_local Arena* Arena::current_ = nullptr;
+
+Arena::Arena(size_t blockSize) : blockSize_(blockSize) {}
+
+Arena::~Arena() {
+    Block* block = first_;
+    while (block) {
+        Block* next = block->next;
+        ::std::free(block);
+        block = next;
+    }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    if (block_) {
+        size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (start + size <= block_->size) {
+            offset_ = start + size;
+            return reinterpret_cast<char*>(block_ + 1) + start;
+        }
+    }
+
+    block_ = nextBlock(size + alignment);
+    size_t start = (reinterpret_cast<uintptr_t>(block_ + 1) % alignment) == 0 ? 0 :
+                   alignment - reinterpret_cast<uintptr_t>(block_ + 1) % alignment;
+    offset_ = start + size;
+    return reinterpret_cast<char*>(block_ + 1) + start;
+}
+
+// Reuses the next retained block when it is big enough, otherwise links a new one in after the current block.
+Arena::Block* Arena::nextBlock(size_t minSize) {
+    Block* next = block_ ? block_->next : first_;
+    if (next && next->size >= minSize) {
+        return next;
+    }
+
+    size_t size = minSize > blockSize_ ? minSize : blockSize_;
+    Block* block = static_cast<Block*>(::std::malloc(sizeof(Block) + size));
+    if (!block) {
+        throw ::std::bad_alloc();
+    }
+    block->size = size;
+    block->next = next;
+    if (block_) {
+        block_->next = block;
+    } else {
+        first_ = block;
+    }
+    return block;
+}
+
+::std::string_view Arena::copy(::std::string_view text) {
+    char* data = static_cast<char*>(allocate(text.size(), 1));
+    ::std::memcpy(data, text.data(), text.size());
+    return ::std::string_view(data, text.size());
+}
+
+void Arena::reset() {
+    block_ = first_;
+    offset_ = 0;
+}
+
+}
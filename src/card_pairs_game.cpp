@@ -11,6 +11,15 @@ CardPairsGame::CardPairsGame(Difficulty difficulty)
     pairsFound_ = 0;
 }
 
+void CardPairsGame::reset(Difficulty difficulty) {
+    MemoryGame::reset(difficulty);
+    cards_.clear();
+    flippedCardIds_.clear();
+    movesCount_ = 0;
+    pairsFound_ = 0;
+    totalPairs_ = getCardCount() / 2;
+}
+
 int CardPairsGame::getCardCount() const {
     switch (difficulty_) {
         case Difficulty::EASY:
@@ -45,6 +54,11 @@ void CardPairsGame::generate() {
     }
     
     shuffleCards();
+    
+    dealtVersion_ = ++version_;
+    for (auto& card : cards_) {
+        card.version = version_;
+    }
 }
 
 void CardPairsGame::shuffleCards() {
@@ -66,6 +80,7 @@ bool CardPairsGame::flipCard(int cardId) {
     }
     
     it->flipped = true;
+    it->version = ++version_;
     flippedCardIds_.push_back(cardId);
     
     return true;
@@ -92,11 +107,14 @@ bool CardPairsGame::checkPair(int cardId1, int cardId2) {
     }
     
     movesCount_++;
+    ++version_;
     
     if (it1->value == it2->value) {
         
         it1->matched = true;
         it2->matched = true;
+        it1->version = version_;
+        it2->version = version_;
         pairsFound_++;
         return true;
     }
@@ -105,9 +123,15 @@ bool CardPairsGame::checkPair(int cardId1, int cardId2) {
 }
 
 void CardPairsGame::resetFlippedCards() {
+    bool changed = false;
     for (auto& card : cards_) {
-        if (!card.matched) {
+        if (!card.matched && card.flipped) {
+            if (!changed) {
+                ++version_;
+                changed = true;
+            }
             card.flipped = false;
+            card.version = version_;
         }
     }
     flippedCardIds_.clear();
@@ -0,0 +1,70 @@
+#include "compression.h"
+#include <cstdlib>
+#include <zlib.h>
+
+namespace SimpleHttp {
+
+::std::string gzipCompress(const ::std::string& data, int level) {
+    z_stream stream{};
+    // 15 window bits + 16 selects the gzip wrapper instead of raw zlib.
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return "";
+    }
+
+    ::std::string out;
+    out.resize(deflateBound(&stream, data.size()) + 32);
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    int rc = deflate(&stream, Z_FINISH);
+    size_t written = stream.total_out;
+    deflateEnd(&stream);
+
+    if (rc != Z_STREAM_END) {
+        return "";
+    }
+    out.resize(written);
+    return out;
+}
+
+bool acceptsGzip(const Request& req) {
+    ::std::string value(req.header("Accept-Encoding"));
+    size_t pos = 0;
+    while (pos < value.size()) {
+        size_t end = value.find(',', pos);
+        if (end == ::std::string::npos) end = value.size();
+        ::std::string token = value.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t first = token.find_first_not_of(" \t");
+        if (first == ::std::string::npos) continue;
+        token = token.substr(first);
+
+        size_t semi = token.find(';');
+        ::std::string coding = token.substr(0, semi);
+        coding = coding.substr(0, coding.find_last_not_of(" \t") + 1);
+        if (coding != "gzip" && coding != "*") continue;
+
+        if (semi != ::std::string::npos) {
+            size_t q = token.find("q=", semi);
+            if (q != ::std::string::npos && ::std::strtod(token.c_str() + q + 2, nullptr) <= 0.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool isCompressibleType(const ::std::string& contentType) {
+    return contentType.compare(0, 5, "text/") == 0 ||
+           contentType.compare(0, 16, "application/json") == 0 ||
+           contentType.compare(0, 16, "application/cbor") == 0 ||
+           contentType.compare(0, 22, "application/javascript") == 0 ||
+           contentType.compare(0, 13, "image/svg+xml") == 0;
+}
+
+}
@@ -0,0 +1,115 @@
+#include "game_registry.h"
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace MemoryTrainer {
+
+GameRegistry::GameRegistry(size_t shardCount) : shardBits_(0) {
+    if (shardCount == 0) {
+        shardCount = 4 * ::std::max(1u, ::std::thread::hardware_concurrency());
+    }
+    shardCount_ = 1;
+    while (shardCount_ < shardCount) {
+        shardCount_ <<= 1;
+        ++shardBits_;
+    }
+    shards_.reset(new Shard[shardCount_]);
+}
+
+// The unordered_map inside a shard buckets by the same hash, so the shard is
+// taken from the top bits of a mixed copy rather than from the low bits.
+GameRegistry::Shard& GameRegistry::shardFor(const GameId& gameId) const {
+    if (shardBits_ == 0) {
+        return shards_[0];
+    }
+    uint64_t hash = static_cast<uint64_t>(IdHash()(gameId));
+    hash *= 0x9E3779B97F4A7C15ULL;
+    return shards_[hash >> (64 - shardBits_)];
+}
+
+bool GameRegistry::insert(const GameId& gameId, ::std::shared_ptr<MemoryGame> game) {
+    Shard& shard = shardFor(gameId);
+    ::std::lock_guard<::std::mutex> lock(shard.mutex);
+    return shard.games.emplace(gameId, ::std::move(game)).second;
+}
+
+::std::shared_ptr<MemoryGame> GameRegistry::find(const GameId& gameId) const {
+    Shard& shard = shardFor(gameId);
+    ::std::lock_guard<::std::mutex> lock(shard.mutex);
+    auto it = shard.games.find(gameId);
+    return it != shard.games.end() ? it->second : nullptr;
+}
+
+bool GameRegistry::erase(const GameId& gameId) {
+    // The game is released after the lock, in case it is the last reference.
+    ::std::shared_ptr<MemoryGame> removed;
+    Shard& shard = shardFor(gameId);
+    ::std::lock_guard<::std::mutex> lock(shard.mutex);
+    auto it = shard.games.find(gameId);
+    if (it == shard.games.end()) {
+        return false;
+    }
+    removed = ::std::move(it->second);
+    shard.games.erase(it);
+    return true;
+}
+
+void GameRegistry::clear() {
+    for (size_t i = 0; i < shardCount_; ++i) {
+        ::std::unordered_map<GameId, ::std::shared_ptr<MemoryGame>, IdHash> removed;
+        {
+            ::std::lock_guard<::std::mutex> lock(shards_[i].mutex);
+            removed.swap(shards_[i].games);
+        }
+    }
+}
+
+size_t GameRegistry::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shardCount_; ++i) {
+        ::std::lock_guard<::std::mutex> lock(shards_[i].mutex);
+        total += shards_[i].games.size();
+    }
+    return total;
+}
+
+void GameRegistry::forEach(const Visitor& visit) const {
+    for (size_t i = 0; i < shardCount_; ++i) {
+        ::std::lock_guard<::std::mutex> lock(shards_[i].mutex);
+        for (const auto& entry : shards_[i].games) {
+            visit(entry.first, entry.second);
+        }
+    }
+}
+
+size_t GameRegistry::eraseIf(const Predicate& pred) {
+    size_t erased = 0;
+    for (size_t i = 0; i < shardCount_; ++i) {
+        erased += eraseIf(i, pred, SIZE_MAX);
+    }
+    return erased;
+}
+
+size_t GameRegistry::eraseIf(size_t shard, const Predicate& pred, size_t limit) {
+    if (shard >= shardCount_) {
+        return 0;
+    }
+    ::std::vector<::std::shared_ptr<MemoryGame>> removed;
+    {
+        ::std::lock_guard<::std::mutex> lock(shards_[shard].mutex);
+        auto& games = shards_[shard].games;
+        for (auto it = games.begin(); it != games.end() && removed.size() < limit;) {
+            if (pred(it->first, *it->second)) {
+                removed.push_back(::std::move(it->second));
+                it = games.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return removed.size();
+}
+
+}
@@ -0,0 +1,274 @@
+#include "http_parser.h"
+#include <cstring>
+
+namespace SimpleHttp {
+
+namespace {
+
+const size_t kMaxContentLength = static_cast<size_t>(1) << 40;
+
+inline char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+::std::string_view trim(::std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+    return value;
+}
+
+bool containsTokenIgnoreCase(::std::string_view value, ::std::string_view token) {
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        if (equalsIgnoreCase(trim(value.substr(0, comma)), token)) {
+            return true;
+        }
+        if (comma == ::std::string_view::npos) break;
+        value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool parseContentLength(::std::string_view value, size_t& out) {
+    value = trim(value);
+    if (value.empty()) {
+        return false;
+    }
+    size_t result = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + static_cast<size_t>(c - '0');
+        if (result > kMaxContentLength) return false;
+    }
+    out = result;
+    return true;
+}
+
+void parseQuery(char* data, size_t size, Request& req) {
+    size_t pos = 0;
+    while (pos < size && req.queryParamCount < Request::kMaxQueryParams) {
+        char* pair = data + pos;
+        char* ampersand = static_cast<char*>(::std::memchr(pair, '&', size - pos));
+        size_t pairLen = ampersand ? static_cast<size_t>(ampersand - pair) : size - pos;
+        pos += pairLen + 1;
+        if (pairLen == 0) continue;
+
+        char* equals = static_cast<char*>(::std::memchr(pair, '=', pairLen));
+        size_t nameLen = equals ? static_cast<size_t>(equals - pair) : pairLen;
+        if (nameLen == 0) continue;
+
+        QueryParam& param = req.queryParams[req.queryParamCount++];
+        param.name = ::std::string_view(pair, percentDecode(pair, nameLen, true));
+        if (equals) {
+            char* value = equals + 1;
+            size_t valueLen = pairLen - nameLen - 1;
+            param.value = ::std::string_view(value, percentDecode(value, valueLen, true));
+        } else {
+            param.value = ::std::string_view();
+        }
+    }
+}
+
+}
+
+bool equalsIgnoreCase(::std::string_view a, ::std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (toLower(a[i]) != toLower(b[i])) return false;
+    }
+    return true;
+}
+
+size_t percentDecode(char* data, size_t size, bool plusAsSpace) {
+    size_t out = 0;
+    for (size_t i = 0; i < size; ++i) {
+        char c = data[i];
+        if (c == '%' && i + 2 < size) {
+            int hi = hexValue(data[i + 1]);
+            int lo = hexValue(data[i + 2]);
+            if (hi >= 0 && lo >= 0) {
+                data[out++] = static_cast<char>((hi << 4) | lo);
+                i += 2;
+                continue;
+            }
+        }
+        data[out++] = (plusAsSpace && c == '+') ? ' ' : c;
+    }
+    return out;
+}
+
+::std::string_view Request::header(::std::string_view name) const {
+    for (size_t i = 0; i < headerCount; ++i) {
+        if (equalsIgnoreCase(headers[i].name, name)) {
+            return headers[i].value;
+        }
+    }
+    return ::std::string_view();
+}
+
+bool Request::hasHeader(::std::string_view name) const {
+    for (size_t i = 0; i < headerCount; ++i) {
+        if (equalsIgnoreCase(headers[i].name, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+::std::string_view Request::query(::std::string_view name, ::std::string_view fallback) const {
+    for (size_t i = 0; i < queryParamCount; ++i) {
+        if (queryParams[i].name == name) {
+            return queryParams[i].value;
+        }
+    }
+    return fallback;
+}
+
+bool Request::hasQuery(::std::string_view name) const {
+    for (size_t i = 0; i < queryParamCount; ++i) {
+        if (queryParams[i].name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Request::keepAlive() const {
+    ::std::string_view connection = header("Connection");
+    if (version == "HTTP/1.0") {
+        return containsTokenIgnoreCase(connection, "keep-alive");
+    }
+    return !containsTokenIgnoreCase(connection, "close");
+}
+
+void RequestParser::reset() {
+    scanned_ = 0;
+    headerSize_ = 0;
+    contentLength_ = 0;
+    queryOffset_ = 0;
+    queryLength_ = 0;
+}
+
+RequestParser::Status RequestParser::parse(char* data, size_t size, Request& req) {
+    if (headerSize_ == 0) {
+        // Resume three bytes back so a terminator split across reads is still found.
+        size_t from = scanned_ > 3 ? scanned_ - 3 : 0;
+        ::std::string_view buf(data, size);
+        size_t end = buf.find("\r\n\r\n", from);
+        if (end == ::std::string_view::npos) {
+            scanned_ = size;
+            return Status::INCOMPLETE;
+        }
+        headerSize_ = end + 4;
+
+        Status head = parseHead(data, req);
+        if (head != Status::COMPLETE) {
+            return head;
+        }
+        if (size < requestSize()) {
+            return Status::INCOMPLETE;
+        }
+        req.body = ::std::string_view(data + headerSize_, contentLength_);
+        parseQuery(data + queryOffset_, queryLength_, req);
+        return Status::COMPLETE;
+    }
+
+    if (size < requestSize()) {
+        return Status::INCOMPLETE;
+    }
+    // The buffer may have moved since the headers were seen, so rebuild the views.
+    req = Request();
+    Status head = parseHead(data, req);
+    if (head != Status::COMPLETE) {
+        return head;
+    }
+    req.body = ::std::string_view(data + headerSize_, contentLength_);
+    parseQuery(data + queryOffset_, queryLength_, req);
+    return Status::COMPLETE;
+}
+
+RequestParser::Status RequestParser::parseHead(char* data, Request& req) {
+    ::std::string_view head(data, headerSize_ - 4);
+
+    size_t lineEnd = head.find("\r\n");
+    ::std::string_view requestLine = head.substr(0, lineEnd);
+
+    size_t sp1 = requestLine.find(' ');
+    if (sp1 == ::std::string_view::npos || sp1 == 0) {
+        return Status::BAD_REQUEST;
+    }
+    size_t sp2 = requestLine.find(' ', sp1 + 1);
+    if (sp2 == ::std::string_view::npos || sp2 == sp1 + 1) {
+        return Status::BAD_REQUEST;
+    }
+    req.method = requestLine.substr(0, sp1);
+    req.version = requestLine.substr(sp2 + 1);
+    if (req.version.substr(0, 5) != "HTTP/") {
+        return Status::BAD_REQUEST;
+    }
+
+    char* target = data + sp1 + 1;
+    size_t targetLen = sp2 - sp1 - 1;
+    char* question = static_cast<char*>(::std::memchr(target, '?', targetLen));
+    // Query parameters are decoded in place, so that waits until the request is complete.
+    if (question) {
+        req.path = ::std::string_view(target, question - target);
+        queryOffset_ = (question + 1) - data;
+        queryLength_ = targetLen - (question - target) - 1;
+    } else {
+        req.path = ::std::string_view(target, targetLen);
+        queryOffset_ = 0;
+        queryLength_ = 0;
+    }
+
+    contentLength_ = 0;
+    bool hasContentLength = false;
+    bool hasTransferEncoding = false;
+    size_t pos = lineEnd == ::std::string_view::npos ? head.size() : lineEnd + 2;
+    while (pos < head.size()) {
+        size_t next = head.find("\r\n", pos);
+        if (next == ::std::string_view::npos) next = head.size();
+        ::std::string_view line = head.substr(pos, next - pos);
+        pos = next + 2;
+
+        size_t colon = line.find(':');
+        if (colon == ::std::string_view::npos || colon == 0) {
+            return Status::BAD_REQUEST;
+        }
+        if (req.headerCount == Request::kMaxHeaders) {
+            return Status::BAD_REQUEST;
+        }
+        HeaderField& field = req.headers[req.headerCount++];
+        field.name = line.substr(0, colon);
+        field.value = trim(line.substr(colon + 1));
+
+        // A body framed any other way, or two disagreeing lengths, would let the
+        // next request on the connection start at a different byte than a proxy
+        // in front of us thinks it does.
+        if (equalsIgnoreCase(field.name, "Content-Length")) {
+            size_t length;
+            if (!parseContentLength(field.value, length) || (hasContentLength && length != contentLength_)) {
+                return Status::BAD_REQUEST;
+            }
+            contentLength_ = length;
+            hasContentLength = true;
+        } else if (equalsIgnoreCase(field.name, "Transfer-Encoding")) {
+            hasTransferEncoding = true;
+        }
+    }
+    if (hasTransferEncoding) {
+        return hasContentLength ? Status::BAD_REQUEST : Status::NOT_IMPLEMENTED;
+    }
+    return Status::COMPLETE;
+}
+
+}
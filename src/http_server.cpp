@@ -0,0 +1,1277 @@
+#include "http_server.h"
+#include "compression.h"
+#include "http_parser.h"
+#include "io_uring_ring.h"
+#include "rate_limiter.h"
+#include "timer_wheel.h"
+#include "websocket.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+#include <exception>
+
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <strings.h>
+
+namespace SimpleHttp {
+
+namespace {
+
+const int kEpollTimeoutMs = 500;
+const int kMaxEpollEvents = 256;
+const unsigned kTimerTickMs = 100;
+const size_t kMaxPendingOutput = 1024 * 1024;
+const size_t kMaxOutputSegments = 16;
+const size_t kInlineBodyLimit = 2048;      // smaller bodies are copied next to their headers
+const size_t kCoalesceLimit = 16 * 1024;
+const unsigned kUringEntries = 1024;
+const size_t kUringRecvChunk = 8192;
+const size_t kUringFileChunk = 64 * 1024;
+
+// io_uring user_data: a Connection pointer (8-byte aligned) or zero, tagged with the operation.
+enum UringOp : uint64_t {
+    URING_RECV = 1,
+    URING_SEND = 2,
+    URING_READ = 3,
+    URING_ACCEPT = 4,
+    URING_TIMER = 5,
+    URING_CLOSE = 6
+};
+const uint64_t kUringOpMask = 7;
+
+uint64_t monotonicMs() {
+    return ::std::chrono::duration_cast<::std::chrono::milliseconds>(
+        ::std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+uint32_t peerAddress(int fd) {
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (getpeername(fd, (struct sockaddr*)&address, &length) < 0 || address.sin_family != AF_INET) {
+        return 0;
+    }
+    return address.sin_addr.s_addr;
+}
+
+}
+
+struct OutputSegment {
+    ::std::string data;                    // owned bytes: headers and generated bodies
+    SharedBody shared;                     // or a borrowed body
+
+    ::std::string_view bytes() const { return shared.owner ? shared.data : ::std::string_view(data); }
+};
+
+// What a connection is waiting for; each phase has its own deadline.
+enum class ConnectionPhase {
+    NONE,
+    HEADERS,
+    BODY,
+    WRITE,
+    IDLE
+};
+
+struct Connection {
+    int fd;
+    uint32_t remoteAddress = 0;
+    ::std::string in;
+    size_t inOffset = 0;
+    RequestParser parser;
+    Arena arena;
+    ::std::deque<OutputSegment> out;
+    size_t outOffset = 0;                  // bytes of out.front() already written
+    size_t outBytes = 0;
+    FileBody file;
+    off_t fileOffset = 0;
+    bool closeAfterWrite = false;
+    bool peerClosed = false;
+    bool inFlight = false;                 // io_uring backend: one operation at a time per connection
+    bool readPaused = false;               // epoll backend: input left in the kernel until output drains
+    msghdr sendMsg{};
+    iovec sendIov[kMaxOutputSegments];
+    int requestsServed = 0;
+    TimerNode timer;
+    ConnectionPhase phase = ConnectionPhase::NONE;
+    int phaseRequest = 0;                  // requestsServed when the phase began
+    uint64_t phaseStartMs = 0;
+    uint64_t lastWriteMs = 0;
+    ::std::shared_ptr<WebSocketHandler> webSocket;   // set once the connection has been upgraded
+    ::std::string message;                 // fragments of an unfinished WebSocket message
+    bool fragmented = false;
+};
+
+namespace {
+
+bool hasPendingOutput(const Connection& conn) {
+    return !conn.out.empty() || conn.file.fd >= 0;
+}
+
+// A client that pipelines without reading its replies stalls processing behind
+// the unsent output; once a full request's worth of input is also waiting, no
+// more is read until the output moves.
+bool inputBacklogged(const Connection& conn, size_t limit) {
+    return hasPendingOutput(conn) && conn.in.size() - conn.inOffset >= limit;
+}
+
+void appendOwned(Connection& conn, ::std::string_view bytes) {
+    if (bytes.empty()) {
+        return;
+    }
+    if (conn.out.empty() || conn.out.back().shared.owner || conn.out.back().data.size() >= kCoalesceLimit) {
+        conn.out.emplace_back();
+    }
+    conn.out.back().data.append(bytes.data(), bytes.size());
+    conn.outBytes += bytes.size();
+}
+
+// Headers go into an owned segment (coalesced with earlier small responses);
+// large or shared bodies become their own segment so they are never copied.
+void queueResponse(Connection& conn, Response& res) {
+    appendOwned(conn, res.serializeHead());
+
+    ::std::string_view body = res.bodyView();
+    if (body.empty()) {
+        return;
+    }
+    if (body.size() <= kInlineBodyLimit) {
+        appendOwned(conn, body);
+        return;
+    }
+
+    OutputSegment segment;
+    if (res.shared.owner) {
+        segment.shared = ::std::move(res.shared);
+    } else {
+        segment.data = ::std::move(res.body);
+    }
+    conn.outBytes += body.size();
+    conn.out.push_back(::std::move(segment));
+}
+
+void queueFrame(Connection& conn, WebSocketOpcode opcode, ::std::string_view payload) {
+    appendOwned(conn, webSocketFrameHeader(opcode, payload.size()));
+    appendOwned(conn, payload);
+}
+
+// Drops consumed input; whatever follows is the start of the next request or frame.
+void compactInput(Connection& conn) {
+    if (conn.inOffset == conn.in.size()) {
+        conn.in.clear();
+        conn.inOffset = 0;
+    } else if (conn.inOffset > 0) {
+        conn.in.erase(0, conn.inOffset);
+        conn.inOffset = 0;
+    }
+}
+
+size_t gatherOutput(const Connection& conn, iovec* iov, size_t maxSegments) {
+    size_t count = 0;
+    size_t offset = conn.outOffset;
+    for (const auto& segment : conn.out) {
+        if (count == maxSegments) break;
+        ::std::string_view bytes = segment.bytes();
+        iov[count].iov_base = const_cast<char*>(bytes.data() + offset);
+        iov[count].iov_len = bytes.size() - offset;
+        offset = 0;
+        ++count;
+    }
+    return count;
+}
+
+void consumeOutput(Connection& conn, size_t written) {
+    conn.outBytes -= written;
+    while (written > 0) {
+        size_t left = conn.out.front().bytes().size() - conn.outOffset;
+        if (written < left) {
+            conn.outOffset += written;
+            return;
+        }
+        written -= left;
+        conn.out.pop_front();
+        conn.outOffset = 0;
+    }
+}
+
+// Returns false once the connection should be closed.
+bool flushConnection(Connection& conn) {
+    while (!conn.out.empty()) {
+        iovec iov[kMaxOutputSegments];
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = gatherOutput(conn, iov, kMaxOutputSegments);
+
+        ssize_t sent = sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+        if (sent > 0) {
+            consumeOutput(conn, sent);
+            conn.lastWriteMs = monotonicMs();
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    conn.outOffset = 0;
+
+    while (conn.file.fd >= 0 && static_cast<size_t>(conn.fileOffset) < conn.file.size) {
+        ssize_t sent = sendfile(conn.fd, conn.file.fd, &conn.fileOffset, conn.file.size - conn.fileOffset);
+        if (sent > 0) {
+            conn.lastWriteMs = monotonicMs();
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    conn.file = FileBody{};
+    conn.fileOffset = 0;
+
+    if (conn.closeAfterWrite) {
+        shutdown(conn.fd, SHUT_WR);
+        return false;
+    }
+    return true;
+}
+
+}
+
+const char* reasonPhrase(int statusCode) {
+    switch (statusCode) {
+        case 100: return "Continue";
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 307: return "Temporary Redirect";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 406: return "Not Acceptable";
+        case 408: return "Request Timeout";
+        case 409: return "Conflict";
+        case 410: return "Gone";
+        case 411: return "Length Required";
+        case 412: return "Precondition Failed";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        case 422: return "Unprocessable Entity";
+        case 426: return "Upgrade Required";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        case 505: return "HTTP Version Not Supported";
+    }
+    if (statusCode >= 200 && statusCode < 300) return "OK";
+    if (statusCode >= 400 && statusCode < 500) return "Bad Request";
+    if (statusCode >= 500) return "Internal Server Error";
+    return "Unknown";
+}
+
+// Weak comparison (RFC 9110 13.1.2): W/ is ignored on both sides.
+bool etagMatches(::std::string_view header, ::std::string_view etag) {
+    auto trim = [](::std::string_view value) {
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+        return value;
+    };
+    auto opaque = [](::std::string_view tag) {
+        if (tag.compare(0, 2, "W/") == 0) tag.remove_prefix(2);
+        return tag;
+    };
+
+    header = trim(header);
+    if (header == "*") {
+        return true;
+    }
+    etag = opaque(etag);
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        if (opaque(trim(header.substr(0, comma))) == etag) {
+            return true;
+        }
+        if (comma == ::std::string_view::npos) break;
+        header.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool CaseInsensitiveLess::operator()(const ::std::string& a, const ::std::string& b) const {
+    return strcasecmp(a.c_str(), b.c_str()) < 0;
+}
+
+::std::string Response::serializeHead() const {
+    ::std::string head;
+    head.reserve(256);
+    head += "HTTP/1.1 ";
+    head += ::std::to_string(statusCode);
+    head += ' ';
+    head += reasonPhrase(statusCode);
+    head += "\r\n";
+
+    if (!headers.count("Content-Type")) {
+        head += "Content-Type: application/json\r\n";
+    }
+    if (!headers.count("Access-Control-Allow-Origin")) {
+        head += "Access-Control-Allow-Origin: *\r\n";
+    }
+    for (const auto& header : headers) {
+        head += header.first;
+        head += ": ";
+        head += header.second;
+        head += "\r\n";
+    }
+    if (statusCode >= 200 && statusCode != 304 && statusCode != 204) {
+        head += "Content-Length: ";
+        head += ::std::to_string(file.fd >= 0 ? file.size : bodyView().size());
+        head += "\r\n";
+    }
+    head += "\r\n";
+    return head;
+}
+
+::std::string Response::toString() const {
+    ::std::string_view payload = bodyView();
+    ::std::string result = serializeHead();
+    result.append(payload.data(), payload.size());
+    return result;
+}
+
+Server::Server(int port) : Server(port, ServerConfig{}) {}
+
+Server::Server(int port, const ServerConfig& config)
+    : port_(port), config_(config), running_(false) {}
+
+void Server::setRateLimiter(RateLimiter* limiter) {
+    rateLimiter_ = limiter;
+}
+
+void Server::start(Handler handler) {
+    handler_ = handler;
+    running_ = true;
+
+    bool reusePort = config_.reusePortListeners > 0;
+    int listenerCount = reusePort ? config_.reusePortListeners : 1;
+
+    ::std::vector<int> listenSockets;
+    for (int i = 0; i < listenerCount; ++i) {
+        int serverSocket = openListenSocket(reusePort);
+        if (serverSocket < 0) {
+            for (int fd : listenSockets) close(fd);
+            return;
+        }
+        listenSockets.push_back(serverSocket);
+        listeners_.push_back(::std::make_unique<ListenerCounters>());
+    }
+
+    if (config_.ioModel == IoModel::IO_URING && !IoUring::available()) {
+        ::std::cerr << "io_uring unavailable (" << ::std::strerror(errno) << "), falling back to epoll" << ::std::endl;
+        config_.ioModel = IoModel::EPOLL;
+    }
+
+    const char* mode = config_.ioModel == IoModel::IO_URING ? "io_uring" :
+                       config_.ioModel == IoModel::EPOLL ? "epoll" : "worker pool";
+    ::std::cout << "Server started on port " << port_ << " (" << mode;
+    if (reusePort) {
+        ::std::cout << ", " << listenerCount << " SO_REUSEPORT listeners";
+    }
+    ::std::cout << ")" << ::std::endl;
+
+    if (config_.ioModel != IoModel::THREAD_POOL) {
+        runEventLoops(listenSockets);
+    } else {
+        runWorkerPool(listenSockets);
+    }
+
+    for (int fd : listenSockets) {
+        close(fd);
+    }
+}
+
+void Server::stop() {
+    running_ = false;
+    queueCv_.notify_all();
+}
+
+ServerStats Server::stats() {
+    ServerStats result;
+    result.acceptedConnections = acceptedConnections_;
+    result.rejectedConnections = rejectedConnections_;
+    result.timedOutConnections = timedOutConnections_;
+    result.activeConnections = activeConnections_;
+    result.queueCapacity = config_.maxQueuedConnections;
+    {
+        ::std::lock_guard<::std::mutex> lock(queueMutex_);
+        result.queueDepth = pendingSockets_.size();
+    }
+    for (const auto& listener : listeners_) {
+        ListenerStats entry;
+        entry.acceptedConnections = listener->accepted;
+        entry.activeConnections = listener->active;
+        result.listeners.push_back(entry);
+    }
+    return result;
+}
+
+int Server::openListenSocket(bool reusePort) {
+    int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (serverSocket < 0) {
+        ::std::cerr << "Error creating socket" << ::std::endl;
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reusePort && setsockopt(serverSocket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        ::std::cerr << "Error enabling SO_REUSEPORT" << ::std::endl;
+        close(serverSocket);
+        return -1;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port_);
+
+    if (bind(serverSocket, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        ::std::cerr << "Error binding socket" << ::std::endl;
+        close(serverSocket);
+        return -1;
+    }
+
+    if (listen(serverSocket, config_.listenBacklog) < 0) {
+        ::std::cerr << "Error listening" << ::std::endl;
+        close(serverSocket);
+        return -1;
+    }
+
+    return serverSocket;
+}
+
+void Server::runWorkerPool(const ::std::vector<int>& listenSockets) {
+    int threadCount = config_.workerThreads;
+    if (threadCount <= 0) {
+        threadCount = 4 * static_cast<int>(::std::thread::hardware_concurrency());
+        if (threadCount <= 0) threadCount = 4;
+    }
+
+    ::std::vector<::std::thread> workers;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ::std::vector<::std::thread> acceptors;
+    for (size_t i = 1; i < listenSockets.size(); ++i) {
+        ListenerCounters* listener = listeners_[i].get();
+        int serverSocket = listenSockets[i];
+        acceptors.emplace_back([this, serverSocket, listener]() { acceptLoop(serverSocket, *listener); });
+    }
+    acceptLoop(listenSockets[0], *listeners_[0]);
+
+    for (auto& acceptor : acceptors) {
+        acceptor.join();
+    }
+    queueCv_.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void Server::acceptLoop(int serverSocket, ListenerCounters& listener) {
+    while (running_) {
+        sockaddr_in clientAddress{};
+        socklen_t clientLen = sizeof(clientAddress);
+        int clientSocket = accept(serverSocket, (struct sockaddr*)&clientAddress, &clientLen);
+
+        if (clientSocket < 0) {
+            continue;
+        }
+        ++acceptedConnections_;
+        ++listener.accepted;
+
+        bool queued = false;
+        {
+            ::std::lock_guard<::std::mutex> lock(queueMutex_);
+            if (pendingSockets_.size() < config_.maxQueuedConnections) {
+                pendingSockets_.push_back({clientSocket, &listener});
+                queued = true;
+            }
+        }
+
+        if (queued) {
+            queueCv_.notify_one();
+        } else {
+            rejectConnection(clientSocket);
+        }
+    }
+}
+
+void Server::workerLoop() {
+    while (true) {
+        PendingConnection pending;
+        {
+            ::std::unique_lock<::std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this]() { return !pendingSockets_.empty() || !running_; });
+            if (pendingSockets_.empty()) {
+                return;
+            }
+            pending = pendingSockets_.front();
+            pendingSockets_.pop_front();
+        }
+
+        ++activeConnections_;
+        ++pending.listener->active;
+        handleClient(pending.fd);
+        --pending.listener->active;
+        --activeConnections_;
+    }
+}
+
+// Answers straight from the accept thread so an overloaded pool sheds load instead of queueing it.
+void Server::rejectConnection(int clientSocket) {
+    ++rejectedConnections_;
+
+    Response res;
+    res.statusCode = 503;
+    res.body = "{\"error\":\"Server overloaded\"}";
+    res.headers["Retry-After"] = ::std::to_string(config_.retryAfterSeconds);
+    res.headers["Connection"] = "close";
+
+    ::std::string responseStr = res.toString();
+    send(clientSocket, responseStr.data(), responseStr.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    shutdown(clientSocket, SHUT_WR);
+    close(clientSocket);
+}
+
+void Server::runEventLoops(const ::std::vector<int>& listenSockets) {
+    // io_uring completes EAGAIN straight back for O_NONBLOCK sockets instead of waiting, so only epoll needs it.
+    for (int serverSocket : listenSockets) {
+        if (config_.ioModel == IoModel::EPOLL && !setNonBlocking(serverSocket)) {
+            ::std::cerr << "Error making listen socket non-blocking" << ::std::endl;
+            return;
+        }
+    }
+
+    auto runLoop = [this](int serverSocket, bool shared, ListenerCounters* listener) {
+        if (config_.ioModel == IoModel::IO_URING) {
+            uringLoop(serverSocket, *listener);
+        } else {
+            eventLoop(serverSocket, shared, *listener);
+        }
+    };
+
+    // With SO_REUSEPORT the kernel balances connections across sockets and every
+    // socket gets its own loop; otherwise all loops share the single listen socket.
+    ::std::vector<::std::thread> loops;
+    if (listenSockets.size() > 1) {
+        for (size_t i = 1; i < listenSockets.size(); ++i) {
+            loops.emplace_back(runLoop, listenSockets[i], false, listeners_[i].get());
+        }
+        runLoop(listenSockets[0], false, listeners_[0].get());
+    } else {
+        int threadCount = config_.eventLoopThreads;
+        if (threadCount <= 0) {
+            threadCount = static_cast<int>(::std::thread::hardware_concurrency());
+            if (threadCount <= 0) threadCount = 1;
+        }
+
+        for (int i = 1; i < threadCount; ++i) {
+            loops.emplace_back(runLoop, listenSockets[0], true, listeners_[0].get());
+        }
+        runLoop(listenSockets[0], true, listeners_[0].get());
+    }
+
+    for (auto& loop : loops) {
+        loop.join();
+    }
+}
+
+void Server::eventLoop(int serverSocket, bool shared, ListenerCounters& listener) {
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        ::std::cerr << "Error creating epoll instance" << ::std::endl;
+        return;
+    }
+
+    // A shared listen socket is watched by every loop; EPOLLEXCLUSIVE wakes only one of them per connection.
+    epoll_event listenEvent{};
+    listenEvent.events = shared ? (EPOLLIN | EPOLLEXCLUSIVE) : EPOLLIN;
+    listenEvent.data.ptr = nullptr;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, serverSocket, &listenEvent) < 0) {
+        ::std::cerr << "Error registering listen socket" << ::std::endl;
+        close(epollFd);
+        return;
+    }
+
+    ::std::unordered_map<int, ::std::unique_ptr<Connection>> connections;
+    epoll_event events[kMaxEpollEvents];
+    char buffer[8192];
+    TimerWheel timers(monotonicMs(), kTimerTickMs);
+    ::std::vector<TimerNode*> expired;
+
+    auto closeConnection = [&](Connection* conn) {
+        timers.cancel(conn->timer);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+        close(conn->fd);
+        connections.erase(conn->fd);
+        --activeConnections_;
+        --listener.active;
+    };
+
+    while (running_) {
+        int timeoutMs = timers.size() > 0 ? static_cast<int>(kTimerTickMs) : kEpollTimeoutMs;
+        int ready = epoll_wait(epollFd, events, kMaxEpollEvents, timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            ::std::cerr << "epoll_wait failed: " << ::std::strerror(errno) << ::std::endl;
+            break;
+        }
+        uint64_t now = monotonicMs();
+
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                while (true) {
+                    int clientSocket = accept4(serverSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (clientSocket < 0) break;
+
+                    auto conn = ::std::make_unique<Connection>();
+                    conn->fd = clientSocket;
+                    conn->remoteAddress = peerAddress(clientSocket);
+                    conn->timer.owner = conn.get();
+
+                    epoll_event clientEvent{};
+                    clientEvent.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+                    clientEvent.data.ptr = conn.get();
+                    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSocket, &clientEvent) < 0) {
+                        close(clientSocket);
+                        continue;
+                    }
+                    armTimeout(*conn, timers, now);
+                    connections[clientSocket] = ::std::move(conn);
+                    ++acceptedConnections_;
+                    ++activeConnections_;
+                    ++listener.accepted;
+                    ++listener.active;
+                }
+                continue;
+            }
+
+            Connection* conn = static_cast<Connection*>(events[i].data.ptr);
+            uint32_t flags = events[i].events;
+
+            bool alive = !(flags & EPOLLERR);
+            bool peerClosed = false;
+
+            // Edge-triggered: a paused read gets no new EPOLLIN, so it is resumed
+            // from the EPOLLOUT that drains the output, or right after a flush here.
+            bool readMore = (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) || conn->readPaused;
+            while (alive) {
+                if (readMore) {
+                    conn->readPaused = false;
+                    while (true) {
+                        if (inputBacklogged(*conn, config_.maxRequestSize)) {
+                            conn->readPaused = true;
+                            break;
+                        }
+                        ssize_t bytesRead = recv(conn->fd, buffer, sizeof(buffer), 0);
+                        if (bytesRead > 0) {
+                            conn->in.append(buffer, bytesRead);
+                        } else if (bytesRead == 0) {
+                            peerClosed = true;
+                            break;
+                        } else if (errno == EINTR) {
+                            continue;
+                        } else {
+                            if (errno != EAGAIN && errno != EWOULDBLOCK) alive = false;
+                            break;
+                        }
+                    }
+                }
+
+                // Serve pipelined requests in order, flushing between batches so output stays bounded.
+                while (alive) {
+                    bool produced = processRequests(*conn);
+                    alive = flushConnection(*conn);
+                    if (!alive || !produced || hasPendingOutput(*conn)) {
+                        break;
+                    }
+                }
+
+                readMore = conn->readPaused && !inputBacklogged(*conn, config_.maxRequestSize);
+                if (!readMore) {
+                    break;
+                }
+            }
+
+            if (alive && peerClosed && !hasPendingOutput(*conn)) {
+                alive = false;
+            }
+
+            if (!alive) {
+                closeConnection(conn);
+            } else {
+                armTimeout(*conn, timers, now);
+            }
+        }
+
+        timers.advance(monotonicMs(), expired);
+        for (TimerNode* node : expired) {
+            ++timedOutConnections_;
+            closeConnection(static_cast<Connection*>(node->owner));
+        }
+        expired.clear();
+    }
+
+    for (auto& entry : connections) {
+        close(entry.first);
+    }
+    activeConnections_ -= connections.size();
+    listener.active -= connections.size();
+    close(epollFd);
+}
+
+// Same request pipeline as eventLoop, but accept, recv, send, file reads and close
+// are io_uring operations submitted in one batch per loop iteration. Each connection
+// has at most one operation in flight, so its buffers are never touched concurrently.
+void Server::uringLoop(int serverSocket, ListenerCounters& listener) {
+    IoUring ring;
+    if (!ring.init(kUringEntries)) {
+        ::std::cerr << "Error creating io_uring instance: " << ::std::strerror(errno) << ::std::endl;
+        return;
+    }
+
+    ::std::unordered_map<Connection*, ::std::unique_ptr<Connection>> connections;
+    bool multishotAccept = true;
+    TimerWheel timers(monotonicMs(), kTimerTickMs);
+    ::std::vector<TimerNode*> expired;
+
+    auto userData = [](Connection* conn, UringOp op) {
+        return reinterpret_cast<uint64_t>(conn) | op;
+    };
+
+    auto closeConnection = [&](Connection* conn) {
+        timers.cancel(conn->timer);
+        ring.prepareClose(conn->fd, URING_CLOSE);
+        connections.erase(conn);
+        --activeConnections_;
+        --listener.active;
+    };
+
+    // Moves a connection with no operation in flight to its next step.
+    auto advance = [&](Connection* conn) {
+        while (true) {
+            if (!conn->out.empty()) {
+                armTimeout(*conn, timers, monotonicMs());
+                conn->sendMsg = msghdr{};
+                conn->sendMsg.msg_iov = conn->sendIov;
+                conn->sendMsg.msg_iovlen = gatherOutput(*conn, conn->sendIov, kMaxOutputSegments);
+                ring.prepareSendMsg(conn->fd, &conn->sendMsg, userData(conn, URING_SEND));
+                conn->inFlight = true;
+                return;
+            }
+            conn->outOffset = 0;
+
+            if (conn->file.fd >= 0 && static_cast<size_t>(conn->fileOffset) < conn->file.size) {
+                size_t chunk = ::std::min(kUringFileChunk, conn->file.size - conn->fileOffset);
+                conn->out.emplace_back();
+                conn->out.back().data.resize(chunk);
+                armTimeout(*conn, timers, monotonicMs());
+                ring.prepareRead(conn->file.fd, &conn->out.back().data[0], chunk, conn->fileOffset,
+                                 userData(conn, URING_READ));
+                conn->inFlight = true;
+                return;
+            }
+            conn->file = FileBody{};
+            conn->fileOffset = 0;
+
+            if (conn->closeAfterWrite) {
+                shutdown(conn->fd, SHUT_WR);
+                closeConnection(conn);
+                return;
+            }
+            if (processRequests(*conn)) {
+                continue;
+            }
+            if (conn->peerClosed) {
+                closeConnection(conn);
+                return;
+            }
+
+            armTimeout(*conn, timers, monotonicMs());
+            size_t used = conn->in.size();
+            conn->in.resize(used + kUringRecvChunk);
+            ring.prepareRecv(conn->fd, &conn->in[used], kUringRecvChunk, userData(conn, URING_RECV));
+            conn->inFlight = true;
+            return;
+        }
+    };
+
+    ring.prepareAccept(serverSocket, multishotAccept, URING_ACCEPT);
+    ring.prepareTimeout(kTimerTickMs, URING_TIMER);
+
+    while (running_) {
+        int submitted = ring.submitAndWait(1);
+        if (submitted < 0 && submitted != -EINTR && submitted != -EAGAIN && submitted != -EBUSY) {
+            ::std::cerr << "io_uring_enter failed: " << ::std::strerror(-submitted) << ::std::endl;
+            break;
+        }
+
+        IoCompletion completion;
+        while (ring.nextCompletion(completion)) {
+            Connection* conn = reinterpret_cast<Connection*>(completion.userData & ~kUringOpMask);
+            uint64_t op = completion.userData & kUringOpMask;
+
+            if (op == URING_ACCEPT) {
+                if (completion.result >= 0) {
+                    auto owned = ::std::make_unique<Connection>();
+                    Connection* accepted = owned.get();
+                    accepted->fd = completion.result;
+                    accepted->remoteAddress = peerAddress(completion.result);
+                    accepted->timer.owner = accepted;
+                    connections[accepted] = ::std::move(owned);
+                    ++acceptedConnections_;
+                    ++activeConnections_;
+                    ++listener.accepted;
+                    ++listener.active;
+                    advance(accepted);
+                } else if (completion.result == -EINVAL && multishotAccept) {
+                    // Kernels before 5.19 reject multishot accept; re-arm one accept at a time.
+                    multishotAccept = false;
+                }
+                if (!completion.more) {
+                    ring.prepareAccept(serverSocket, multishotAccept, URING_ACCEPT);
+                }
+                continue;
+            }
+
+            if (op == URING_TIMER) {
+                // Shutting an expired socket down completes its pending operation, which then closes it.
+                timers.advance(monotonicMs(), expired);
+                for (TimerNode* node : expired) {
+                    ++timedOutConnections_;
+                    shutdown(static_cast<Connection*>(node->owner)->fd, SHUT_RDWR);
+                }
+                expired.clear();
+                ring.prepareTimeout(kTimerTickMs, URING_TIMER);
+                continue;
+            }
+
+            if (op == URING_CLOSE || !conn) {
+                continue;
+            }
+
+            conn->inFlight = false;
+            int result = completion.result;
+
+            if (op == URING_RECV) {
+                conn->in.resize(conn->in.size() - kUringRecvChunk + (result > 0 ? result : 0));
+                if (result == 0) {
+                    conn->peerClosed = true;
+                } else if (result < 0 && result != -EINTR && result != -EAGAIN) {
+                    closeConnection(conn);
+                    continue;
+                }
+            } else if (op == URING_SEND) {
+                if (result < 0 && result != -EINTR && result != -EAGAIN) {
+                    closeConnection(conn);
+                    continue;
+                }
+                if (result > 0) {
+                    consumeOutput(*conn, result);
+                    conn->lastWriteMs = monotonicMs();
+                }
+            } else if (op == URING_READ) {
+                if (result <= 0) {
+                    closeConnection(conn);
+                    continue;
+                }
+                conn->out.back().data.resize(result);
+                conn->outBytes += result;
+                conn->fileOffset += result;
+            }
+
+            advance(conn);
+        }
+    }
+
+    for (auto& entry : connections) {
+        shutdown(entry.second->fd, SHUT_RDWR);
+        close(entry.second->fd);
+    }
+    activeConnections_ -= connections.size();
+    listener.active -= connections.size();
+}
+
+// Starts a new deadline when the connection enters another phase (or another
+// request). Header and body deadlines are not extended by trickling bytes, so a
+// slow client cannot hold a connection open; write deadlines move on progress.
+bool Server::updatePhase(Connection& conn, uint64_t nowMs, uint64_t& deadlineMs) {
+    ConnectionPhase phase;
+    if (hasPendingOutput(conn)) {
+        phase = ConnectionPhase::WRITE;
+    } else if (conn.webSocket) {
+        phase = ConnectionPhase::IDLE;
+    } else if (conn.in.size() > conn.inOffset) {
+        phase = conn.parser.headersComplete() ? ConnectionPhase::BODY : ConnectionPhase::HEADERS;
+    } else {
+        phase = conn.requestsServed == 0 ? ConnectionPhase::HEADERS : ConnectionPhase::IDLE;
+    }
+
+    bool restart = phase != conn.phase || conn.requestsServed != conn.phaseRequest ||
+                   (phase == ConnectionPhase::WRITE && conn.lastWriteMs > conn.phaseStartMs);
+    if (!restart) {
+        return false;
+    }
+
+    int timeoutMs = conn.webSocket ? config_.webSocketIdleTimeoutMs : config_.keepAliveTimeoutMs;
+    if (phase == ConnectionPhase::HEADERS) timeoutMs = config_.headerTimeoutMs;
+    else if (phase == ConnectionPhase::BODY) timeoutMs = config_.bodyTimeoutMs;
+    else if (phase == ConnectionPhase::WRITE) timeoutMs = config_.writeTimeoutMs;
+
+    conn.phase = phase;
+    conn.phaseRequest = conn.requestsServed;
+    conn.phaseStartMs = nowMs;
+    deadlineMs = nowMs + timeoutMs;
+    return true;
+}
+
+void Server::armTimeout(Connection& conn, TimerWheel& timers, uint64_t nowMs) {
+    uint64_t deadlineMs;
+    if (updatePhase(conn, nowMs, deadlineMs)) {
+        timers.schedule(conn.timer, deadlineMs);
+    }
+}
+
+bool Server::processRequests(Connection& conn) {
+    bool produced = false;
+
+    auto reject = [&](int statusCode, const char* body) {
+        Response res;
+        res.statusCode = statusCode;
+        res.body = body;
+        res.headers["Connection"] = "close";
+        queueResponse(conn, res);
+        conn.closeAfterWrite = true;
+        conn.in.clear();
+        conn.inOffset = 0;
+        produced = true;
+    };
+
+    while (!conn.webSocket && !conn.closeAfterWrite && conn.file.fd < 0 && conn.outBytes < kMaxPendingOutput) {
+        size_t available = conn.in.size() - conn.inOffset;
+        if (available == 0) {
+            break;
+        }
+
+        Request req;
+        auto status = conn.parser.parse(&conn.in[conn.inOffset], available, req);
+
+        if (status == RequestParser::Status::BAD_REQUEST) {
+            reject(400, "{\"error\":\"Bad request\"}");
+            break;
+        }
+        if (status == RequestParser::Status::NOT_IMPLEMENTED) {
+            reject(501, "{\"error\":\"Transfer-Encoding is not supported\"}");
+            break;
+        }
+        size_t expected = conn.parser.headersComplete() ? conn.parser.requestSize() : available;
+        if (expected > config_.maxRequestSize) {
+            reject(413, "{\"error\":\"Request too large\"}");
+            break;
+        }
+        if (status == RequestParser::Status::INCOMPLETE) {
+            break;
+        }
+
+        ++conn.requestsServed;
+        bool keepAlive = req.keepAlive() && conn.requestsServed < config_.maxRequestsPerConnection;
+        req.arena = &conn.arena;
+        req.remoteAddress = conn.remoteAddress;
+
+        {
+            Response res;
+            if (!rateLimited(req, res)) {
+                res = dispatch(req);
+                compressResponse(req, res);
+            }
+            if (res.statusCode == 101 && res.upgrade) {
+                conn.webSocket = ::std::move(res.upgrade);
+            } else if (keepAlive) {
+                res.headers["Connection"] = "keep-alive";
+                res.headers["Keep-Alive"] = "timeout=" + ::std::to_string(config_.keepAliveTimeoutMs / 1000) +
+                                            ", max=" + ::std::to_string(config_.maxRequestsPerConnection - conn.requestsServed);
+            } else {
+                res.headers["Connection"] = "close";
+                conn.closeAfterWrite = true;
+            }
+            queueResponse(conn, res);
+            if (res.file.fd >= 0) {
+                conn.file = res.file;
+                conn.fileOffset = 0;
+            }
+        }
+        // The queued response owns or shares its bytes, so request scratch memory can go.
+        conn.arena.reset();
+
+        conn.inOffset += conn.parser.requestSize();
+        conn.parser.reset();
+        produced = true;
+    }
+
+    compactInput(conn);
+    if (conn.webSocket) {
+        produced = processFrames(conn) || produced;
+    }
+    return produced;
+}
+
+// Upgraded connections: control frames are answered here, data messages go to
+// the handler and its reply is queued as a text frame.
+bool Server::processFrames(Connection& conn) {
+    bool produced = false;
+    WebSocketFrameParser parser(config_.maxRequestSize);
+
+    auto fail = [&](uint16_t statusCode) {
+        queueFrame(conn, WebSocketOpcode::CLOSE, webSocketClosePayload(statusCode));
+        conn.closeAfterWrite = true;
+        conn.in.clear();
+        conn.inOffset = 0;
+        produced = true;
+    };
+
+    while (!conn.closeAfterWrite && conn.outBytes < kMaxPendingOutput) {
+        size_t available = conn.in.size() - conn.inOffset;
+        if (available == 0) {
+            break;
+        }
+
+        WebSocketFrame frame;
+        auto status = parser.parse(&conn.in[conn.inOffset], available, frame);
+        if (status == WebSocketFrameParser::Status::INCOMPLETE) {
+            break;
+        }
+        if (status == WebSocketFrameParser::Status::PROTOCOL_ERROR) {
+            fail(1002);
+            break;
+        }
+        if (status == WebSocketFrameParser::Status::TOO_LARGE) {
+            fail(1009);
+            break;
+        }
+        conn.inOffset += parser.frameSize();
+        produced = true;
+
+        ::std::string_view payload(frame.payload, frame.payloadSize);
+        if (frame.opcode == WebSocketOpcode::PING) {
+            queueFrame(conn, WebSocketOpcode::PONG, payload);
+            continue;
+        }
+        if (frame.opcode == WebSocketOpcode::PONG) {
+            continue;
+        }
+        if (frame.opcode == WebSocketOpcode::CLOSE) {
+            queueFrame(conn, WebSocketOpcode::CLOSE, payload.substr(0, 2));
+            conn.closeAfterWrite = true;
+            break;
+        }
+
+        // A continuation must follow an unfinished message, and only a continuation may.
+        if ((frame.opcode == WebSocketOpcode::CONTINUATION) != conn.fragmented) {
+            fail(1002);
+            break;
+        }
+        ::std::string_view message = payload;
+        if (conn.fragmented || !frame.fin) {
+            if (conn.message.size() + payload.size() > config_.maxRequestSize) {
+                fail(1009);
+                break;
+            }
+            conn.message.append(payload.data(), payload.size());
+            conn.fragmented = !frame.fin;
+            if (conn.fragmented) {
+                continue;
+            }
+            message = conn.message;
+        }
+
+        // Counts as a request so the idle deadline restarts after every message.
+        ++conn.requestsServed;
+        ::std::string reply;
+        {
+            ArenaScope scope(&conn.arena);
+            try {
+                reply = conn.webSocket->onMessage(message);
+            } catch (const ::std::exception& e) {
+                ::std::cerr << "Exception in WebSocket handler: " << e.what() << ::std::endl;
+                fail(1011);
+            } catch (...) {
+                ::std::cerr << "Unknown exception in WebSocket handler" << ::std::endl;
+                fail(1011);
+            }
+        }
+        conn.arena.reset();
+        conn.message.clear();
+        if (!reply.empty() && !conn.closeAfterWrite) {
+            queueFrame(conn, WebSocketOpcode::TEXT, reply);
+        }
+    }
+
+    compactInput(conn);
+    return produced;
+}
+
+// Fills in a 429 before the handler parses the body or takes any lock.
+bool Server::rateLimited(const Request& req, Response& res) {
+    if (!rateLimiter_) {
+        return false;
+    }
+    RateLimiter::Decision decision = rateLimiter_->check(req);
+    if (decision.allowed) {
+        return false;
+    }
+    res.statusCode = 429;
+    res.body = "{\"error\":\"Too many requests\"}";
+    res.headers["Content-Type"] = "application/json";
+    res.headers["Retry-After"] = ::std::to_string(decision.retryAfterSeconds);
+    res.headers["Access-Control-Allow-Origin"] = "*";
+    return true;
+}
+
+void Server::compressResponse(const Request& req, Response& res) {
+    if (config_.compressionLevel <= 0 || res.file.fd >= 0 ||
+        res.body.size() < config_.compressionMinSize || res.headers.count("Content-Encoding")) {
+        return;
+    }
+    auto type = res.headers.find("Content-Type");
+    if (type == res.headers.end() || !isCompressibleType(type->second) || !acceptsGzip(req)) {
+        return;
+    }
+
+    ::std::string compressed = gzipCompress(res.body, config_.compressionLevel);
+    if (compressed.empty() || compressed.size() >= res.body.size()) {
+        return;
+    }
+    res.body = ::std::move(compressed);
+    res.headers["Content-Encoding"] = "gzip";
+    auto vary = res.headers.find("Vary");
+    if (vary == res.headers.end()) {
+        res.headers["Vary"] = "Accept-Encoding";
+    } else {
+        vary->second += ", Accept-Encoding";
+    }
+}
+
+Response Server::dispatch(const Request& req) {
+    Response res;
+    ArenaScope scope(req.arena);
+
+    try {
+        res = handler_(req);
+    } catch (const ::std::exception& e) {
+        ::std::cerr << "Exception in handler: " << e.what() << ::std::endl;
+        ::std::cerr << "Request path: " << req.path << ::std::endl;
+        res.statusCode = 500;
+        res.body = "{\"error\":\"Internal server error\"}";
+    } catch (...) {
+        ::std::cerr << "Unknown exception in handler" << ::std::endl;
+        ::std::cerr << "Request path: " << req.path << ::std::endl;
+        res.statusCode = 500;
+        res.body = "{\"error\":\"Internal server error\"}";
+    }
+
+    if (res.body.find("{") == 0 || res.body.find("[") == 0) {
+        res.headers["Content-Type"] = "application/json";
+    }
+    res.headers["Access-Control-Allow-Origin"] = "*";
+
+    return res;
+}
+
+// Worker pool mode blocks per connection, so phase deadlines become socket
+// timeouts: the receive timeout is set to whatever is left of the current phase.
+void Server::handleClient(int clientSocket) {
+    struct timeval sendTimeout;
+    sendTimeout.tv_sec = config_.writeTimeoutMs / 1000;
+    sendTimeout.tv_usec = (config_.writeTimeoutMs % 1000) * 1000;
+    setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+    Connection conn;
+    conn.fd = clientSocket;
+    conn.remoteAddress = peerAddress(clientSocket);
+    char buffer[8192];
+    uint64_t deadlineMs = 0;
+
+    while (true) {
+        // Pipelined requests held back by a sendfile body or the output cap are
+        // served as soon as the earlier responses are out, not after the next recv.
+        bool alive = true;
+        while (alive) {
+            bool produced = processRequests(conn);
+            alive = flushConnection(conn);
+            if (!produced || hasPendingOutput(conn)) {
+                break;
+            }
+        }
+        if (!alive) {
+            break;
+        }
+
+        uint64_t now = monotonicMs();
+        updatePhase(conn, now, deadlineMs);
+        if (now >= deadlineMs) {
+            ++timedOutConnections_;
+            break;
+        }
+        uint64_t remainingMs = deadlineMs - now;
+        struct timeval timeout;
+        timeout.tv_sec = remainingMs / 1000;
+        timeout.tv_usec = (remainingMs % 1000) * 1000;
+        setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        ssize_t bytesRead = recv(clientSocket, buffer, sizeof(buffer), 0);
+        if (bytesRead <= 0) {
+            if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                ++timedOutConnections_;
+            }
+            break;
+        }
+        conn.in.append(buffer, bytesRead);
+    }
+
+    close(clientSocket);
+}
+
+}
@@ -0,0 +1,101 @@
+#include "ids.h"
+#include <atomic>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <openssl/rand.h>
+
+namespace MemoryTrainer {
+
+namespace {
+
+const uint64_t kBlockSize = uint64_t(1) << 32;
+const size_t kRandomBufferSize = 512;
+
+void fillRandom(unsigned char* buffer, size_t size) {
+    if (RAND_bytes(buffer, static_cast<int>(size)) == 1) {
+        return;
+    }
+    ::std::random_device rd;
+    for (size_t i = 0; i < size; i += sizeof(unsigned)) {
+        unsigned value = rd();
+        ::std::memcpy(buffer + i, &value, ::std::min(sizeof(value), size - i));
+    }
+}
+
+// Blocks of 2^32 sequence numbers handed to threads; the first block is
+// random so sequences from different runs do not line up.
+uint64_t takeBlock() {
+    static ::std::atomic<uint64_t> nextBlock{[]() {
+        uint32_t start;
+        fillRandom(reinterpret_cast<unsigned char*>(&start), sizeof(start));
+        return static_cast<uint64_t>(start);
+    }()};
+    return nextBlock.fetch_add(1, ::std::memory_order_relaxed) * kBlockSize;
+}
+
+struct ThreadIdState {
+    uint64_t base = 0;
+    uint64_t used = kBlockSize;
+    unsigned char random[kRandomBufferSize];
+    size_t randomUsed = kRandomBufferSize;
+};
+
+thread_local ThreadIdState idState;
+
+}
+
+Id Id::generate() {
+    ThreadIdState& state = idState;
+    if (state.used == kBlockSize) {
+        state.base = takeBlock();
+        state.used = 0;
+    }
+    if (state.randomUsed == kRandomBufferSize) {
+        fillRandom(state.random, kRandomBufferSize);
+        state.randomUsed = 0;
+    }
+
+    Id id;
+    ::std::memcpy(&id.high, state.random + state.randomUsed, sizeof(id.high));
+    state.randomUsed += sizeof(id.high);
+    id.low = state.base + state.used++;
+    if (id.empty()) {
+        id.high = 1;
+    }
+    return id;
+}
+
+bool Id::parse(::std::string_view text, Id& out) {
+    if (text.size() != 32) {
+        return false;
+    }
+    uint64_t words[2] = {0, 0};
+    for (size_t i = 0; i < 32; ++i) {
+        char c = text[i];
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        words[i / 16] = (words[i / 16] << 4) | digit;
+    }
+    out.high = words[0];
+    out.low = words[1];
+    return true;
+}
+
+::std::string Id::toString() const {
+    static const char kHex[] = "0123456789abcdef";
+    ::std::string text(32, '0');
+    uint64_t words[2] = {high, low};
+    for (size_t i = 0; i < 32; ++i) {
+        text[i] = kHex[(words[i / 16] >> (60 - (i % 16) * 4)) & 0xF];
+    }
+    return text;
+}
+
+}
@@ -0,0 +1,220 @@
+#include "io_uring_ring.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef HAVE_LINUX_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace SimpleHttp {
+
+#ifdef HAVE_LINUX_IO_URING
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+unsigned* ringField(void* ring, uint32_t offset) {
+    return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+}
+
+IoUring::~IoUring() {
+    if (sqEntries_) munmap(sqEntries_, sqEntriesSize_);
+    if (cqRing_ && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+    if (sqRing_) munmap(sqRing_, sqRingSize_);
+    if (ringFd_ >= 0) close(ringFd_);
+}
+
+bool IoUring::init(unsigned entries) {
+    io_uring_params params{};
+    ringFd_ = ioUringSetup(entries, &params);
+    if (ringFd_ < 0) {
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = sqRingSize_ > cqRingSize_ ? sqRingSize_ : cqRingSize_;
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        return false;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            return false;
+        }
+    }
+
+    sqEntriesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqEntries_ = mmap(nullptr, sqEntriesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd_, IORING_OFF_SQES);
+    if (sqEntries_ == MAP_FAILED) {
+        sqEntries_ = nullptr;
+        return false;
+    }
+
+    sqHead_ = ringField(sqRing_, params.sq_off.head);
+    sqTail_ = ringField(sqRing_, params.sq_off.tail);
+    sqMask_ = *ringField(sqRing_, params.sq_off.ring_mask);
+    sqCapacity_ = params.sq_entries;
+    sqArray_ = ringField(sqRing_, params.sq_off.array);
+    cqHead_ = ringField(cqRing_, params.cq_off.head);
+    cqTail_ = ringField(cqRing_, params.cq_off.tail);
+    cqMask_ = *ringField(cqRing_, params.cq_off.ring_mask);
+    cqes_ = static_cast<char*>(cqRing_) + params.cq_off.cqes;
+    return true;
+}
+
+bool IoUring::available() {
+    IoUring probe;
+    return probe.init(2);
+}
+
+void* IoUring::nextEntry() {
+    unsigned tail = *sqTail_;
+    // Ring full: hand the batch to the kernel to make room.
+    while (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqCapacity_) {
+        if (ioUringEnter(ringFd_, pending_, 0, 0) >= 0) {
+            pending_ = 0;
+        }
+    }
+
+    unsigned index = tail & sqMask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqEntries_) + index;
+    ::std::memset(sqe, 0, sizeof(*sqe));
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++pending_;
+    return sqe;
+}
+
+void IoUring::prepareAccept(int fd, bool multishot, uint64_t userData) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(nextEntry());
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (multishot) {
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    }
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareRecv(int fd, void* buffer, size_t length, uint64_t userData) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(nextEntry());
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareSendMsg(int fd, const msghdr* message, uint64_t userData) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(nextEntry());
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(message);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareRead(int fd, void* buffer, size_t length, uint64_t offset, uint64_t userData) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(nextEntry());
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buffer);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->off = offset;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareClose(int fd, uint64_t userData) {
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(nextEntry());
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = userData;
+}
+
+void IoUring::prepareTimeout(unsigned milliseconds, uint64_t userData) {
+    timeout_[0] = milliseconds / 1000;
+    timeout_[1] = static_cast<int64_t>(milliseconds % 1000) * 1000000;
+
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(nextEntry());
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(timeout_);
+    sqe->len = 1;
+    sqe->user_data = userData;
+}
+
+int IoUring::submitAndWait(unsigned waitFor) {
+    int result = ioUringEnter(ringFd_, pending_, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (result < 0) {
+        return -errno;
+    }
+    pending_ -= static_cast<unsigned>(result) < pending_ ? static_cast<unsigned>(result) : pending_;
+    return result;
+}
+
+bool IoUring::nextCompletion(IoCompletion& completion) {
+    unsigned head = *cqHead_;
+    if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const io_uring_cqe& cqe = static_cast<const io_uring_cqe*>(cqes_)[head & cqMask_];
+    completion.userData = cqe.user_data;
+    completion.result = cqe.res;
+    completion.more = cqe.flags & IORING_CQE_F_MORE;
+    __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#else
+
+IoUring::~IoUring() {}
+
+bool IoUring::init(unsigned) {
+    errno = ENOSYS;
+    return false;
+}
+
+bool IoUring::available() {
+    return false;
+}
+
+void* IoUring::nextEntry() { return nullptr; }
+void IoUring::prepareAccept(int, bool, uint64_t) {}
+void IoUring::prepareRecv(int, void*, size_t, uint64_t) {}
+void IoUring::prepareSendMsg(int, const msghdr*, uint64_t) {}
+void IoUring::prepareRead(int, void*, size_t, uint64_t, uint64_t) {}
+void IoUring::prepareClose(int, uint64_t) {}
+void IoUring::prepareTimeout(unsigned, uint64_t) {}
+int IoUring::submitAndWait(unsigned) { return -ENOSYS; }
+bool IoUring::nextCompletion(IoCompletion&) { return false; }
+
+#endif
+
+}
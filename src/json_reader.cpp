@@ -0,0 +1,426 @@
+#include "json_reader.h"
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace SimpleJson {
+
+namespace {
+
+bool isStringSpecial(unsigned char c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+// First quote, backslash or control character at or after p, or end.
+const char* findStringSpecial(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i controlMax = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        // Unsigned c <= 0x1F exactly when max(c, 0x1F) == 0x1F.
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(chunk, controlMax), controlMax));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && !isStringSpecial(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    return p;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseHex4(const char* p, const char* end, uint32_t& out) {
+    if (end - p < 4) {
+        return false;
+    }
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        int digit = hexValue(p[i]);
+        if (digit < 0) return false;
+        out = (out << 4) | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+char* appendUtf8(char* out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        *out++ = static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    return out;
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+}
+
+Value::Iterator& Value::Iterator::operator++() {
+    index_ = doc_->nodes_[index_].end;
+    return *this;
+}
+
+Type Value::type() const {
+    const Document::Node* n = doc_ ? doc_->node(index_) : nullptr;
+    return n ? n->type : Type::MISSING;
+}
+
+::std::string_view Value::asString(::std::string_view fallback) const {
+    return type() == Type::STRING ? doc_->nodes_[index_].text : fallback;
+}
+
+bool Value::asBool(bool fallback) const {
+    return type() == Type::BOOL ? doc_->nodes_[index_].text == "true" : fallback;
+}
+
+double Value::asDouble(double fallback) const {
+    if (type() != Type::NUMBER) {
+        return fallback;
+    }
+    ::std::string_view text = doc_->nodes_[index_].text;
+    double result = fallback;
+    auto parsed = ::std::from_chars(text.data(), text.data() + text.size(), result);
+    return parsed.ec == ::std::errc() ? result : fallback;
+}
+
+bool Value::getInt(int& out) const {
+    if (type() != Type::NUMBER) {
+        return false;
+    }
+    ::std::string_view text = doc_->nodes_[index_].text;
+    int result = 0;
+    auto parsed = ::std::from_chars(text.data(), text.data() + text.size(), result);
+    if (parsed.ec != ::std::errc() || parsed.ptr != text.data() + text.size()) {
+        return false;
+    }
+    out = result;
+    return true;
+}
+
+int Value::asInt(int fallback) const {
+    int result = fallback;
+    return getInt(result) ? result : fallback;
+}
+
+Value Value::operator[](::std::string_view key) const {
+    if (type() != Type::OBJECT) {
+        return Value();
+    }
+    const auto& nodes = doc_->nodes_;
+    uint32_t end = nodes[index_].end;
+    for (uint32_t i = index_ + 1; i < end; i = nodes[i + 1].end) {
+        if (nodes[i].text == key) {
+            return Value(doc_, i + 1);
+        }
+    }
+    return Value();
+}
+
+size_t Value::size() const {
+    Type t = type();
+    return t == Type::ARRAY || t == Type::OBJECT ? doc_->nodes_[index_].count : 0;
+}
+
+Value::Iterator Value::begin() const {
+    if (type() != Type::ARRAY) {
+        return Iterator(doc_, 0);
+    }
+    return Iterator(doc_, index_ + 1);
+}
+
+Value::Iterator Value::end() const {
+    if (type() != Type::ARRAY) {
+        return Iterator(doc_, 0);
+    }
+    return Iterator(doc_, doc_->nodes_[index_].end);
+}
+
+Document::Document(size_t maxDepth, size_t maxSize) : maxDepth_(maxDepth), maxSize_(maxSize) {}
+
+bool Document::parse(::std::string_view text) {
+    nodes_.clear();
+    unescaped_.clear();
+    unescapedSize_ = 0;
+    error_ = nullptr;
+    errorOffset_ = 0;
+    begin_ = pos_ = text.data();
+    end_ = text.data() + text.size();
+
+    if (text.size() > maxSize_) {
+        return fail("Document too large");
+    }
+    nodes_.reserve(16);
+
+    skipWhitespace();
+    if (!parseValue(0)) {
+        nodes_.clear();
+        return false;
+    }
+    skipWhitespace();
+    if (pos_ != end_) {
+        nodes_.clear();
+        return fail("Unexpected data after the document");
+    }
+    return true;
+}
+
+bool Document::fail(const char* message) {
+    error_ = message;
+    errorOffset_ = static_cast<size_t>(pos_ - begin_);
+    return false;
+}
+
+void Document::skipWhitespace() {
+    while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+        ++pos_;
+    }
+}
+
+bool Document::parseValue(size_t depth) {
+    if (pos_ == end_) {
+        return fail("Unexpected end of input");
+    }
+    switch (*pos_) {
+        case '{':
+            return parseContainer(depth, true);
+        case '[':
+            return parseContainer(depth, false);
+        case '"': {
+            ::std::string_view text;
+            if (!parseString(text)) {
+                return false;
+            }
+            uint32_t index = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back({Type::STRING, index + 1, 0, text});
+            return true;
+        }
+        case 't':
+            return parseLiteral("true", Type::BOOL);
+        case 'f':
+            return parseLiteral("false", Type::BOOL);
+        case 'n':
+            return parseLiteral("null", Type::NULL_VALUE);
+        default:
+            if (*pos_ == '-' || isDigit(*pos_)) {
+                return parseNumber();
+            }
+            return fail("Unexpected character");
+    }
+}
+
+bool Document::parseContainer(size_t depth, bool object) {
+    if (depth >= maxDepth_) {
+        return fail("Nesting too deep");
+    }
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back({object ? Type::OBJECT : Type::ARRAY, 0, 0, {}});
+    const char close = object ? '}' : ']';
+
+    ++pos_;
+    skipWhitespace();
+    uint32_t count = 0;
+    if (pos_ < end_ && *pos_ == close) {
+        ++pos_;
+    } else {
+        while (true) {
+            if (object) {
+                if (pos_ == end_ || *pos_ != '"') {
+                    return fail("Expected a member name");
+                }
+                ::std::string_view key;
+                if (!parseString(key)) {
+                    return false;
+                }
+                uint32_t keyIndex = static_cast<uint32_t>(nodes_.size());
+                nodes_.push_back({Type::STRING, keyIndex + 1, 0, key});
+                skipWhitespace();
+                if (pos_ == end_ || *pos_ != ':') {
+                    return fail("Expected ':'");
+                }
+                ++pos_;
+                skipWhitespace();
+            }
+            if (!parseValue(depth + 1)) {
+                return false;
+            }
+            ++count;
+            skipWhitespace();
+            if (pos_ == end_) {
+                return fail("Unexpected end of input");
+            }
+            if (*pos_ == ',') {
+                ++pos_;
+                skipWhitespace();
+                continue;
+            }
+            if (*pos_ == close) {
+                ++pos_;
+                break;
+            }
+            return fail(object ? "Expected ',' or '}'" : "Expected ',' or ']'");
+        }
+    }
+
+    nodes_[index].end = static_cast<uint32_t>(nodes_.size());
+    nodes_[index].count = count;
+    return true;
+}
+
+// Strings without escapes stay views into the input; the rest are decoded into
+// unescaped_, which never needs more room than the input itself.
+bool Document::parseString(::std::string_view& out) {
+    ++pos_;
+    const char* start = pos_;
+    pos_ = findStringSpecial(pos_, end_);
+    if (pos_ == end_) {
+        return fail("Unterminated string");
+    }
+    if (*pos_ == '"') {
+        out = ::std::string_view(start, pos_ - start);
+        ++pos_;
+        return true;
+    }
+    if (*pos_ != '\\') {
+        return fail("Control character in string");
+    }
+
+    if (unescaped_.empty()) {
+        unescaped_.resize(end_ - begin_);
+    }
+    char* outStart = unescaped_.data() + unescapedSize_;
+    char* dst = outStart;
+    const char* run = start;
+    while (true) {
+        ::std::memcpy(dst, run, pos_ - run);
+        dst += pos_ - run;
+        if (pos_ == end_) {
+            return fail("Unterminated string");
+        }
+
+        char c = *pos_;
+        if (c == '"') {
+            ++pos_;
+            break;
+        }
+        if (c != '\\') {
+            return fail("Control character in string");
+        }
+        if (end_ - pos_ < 2) {
+            return fail("Unterminated string");
+        }
+        char escape = pos_[1];
+        pos_ += 2;
+        switch (escape) {
+            case '"': *dst++ = '"'; break;
+            case '\\': *dst++ = '\\'; break;
+            case '/': *dst++ = '/'; break;
+            case 'b': *dst++ = '\b'; break;
+            case 'f': *dst++ = '\f'; break;
+            case 'n': *dst++ = '\n'; break;
+            case 'r': *dst++ = '\r'; break;
+            case 't': *dst++ = '\t'; break;
+            case 'u': {
+                uint32_t codePoint;
+                if (!parseHex4(pos_, end_, codePoint)) {
+                    return fail("Invalid \\u escape");
+                }
+                pos_ += 4;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    uint32_t low;
+                    if (end_ - pos_ < 6 || pos_[0] != '\\' || pos_[1] != 'u' ||
+                        !parseHex4(pos_ + 2, end_, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return fail("Unpaired surrogate in \\u escape");
+                    }
+                    pos_ += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    return fail("Unpaired surrogate in \\u escape");
+                }
+                dst = appendUtf8(dst, codePoint);
+                break;
+            }
+            default:
+                return fail("Invalid escape");
+        }
+        run = pos_;
+        pos_ = findStringSpecial(pos_, end_);
+    }
+
+    out = ::std::string_view(outStart, dst - outStart);
+    unescapedSize_ += dst - outStart;
+    return true;
+}
+
+bool Document::parseNumber() {
+    const char* start = pos_;
+    if (*pos_ == '-') {
+        ++pos_;
+    }
+    if (pos_ == end_ || !isDigit(*pos_)) {
+        return fail("Invalid number");
+    }
+    if (*pos_ == '0') {
+        ++pos_;
+    } else {
+        while (pos_ < end_ && isDigit(*pos_)) ++pos_;
+    }
+    if (pos_ < end_ && *pos_ == '.') {
+        ++pos_;
+        if (pos_ == end_ || !isDigit(*pos_)) {
+            return fail("Invalid number");
+        }
+        while (pos_ < end_ && isDigit(*pos_)) ++pos_;
+    }
+    if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+        ++pos_;
+        if (pos_ < end_ && (*pos_ == '+' || *pos_ == '-')) ++pos_;
+        if (pos_ == end_ || !isDigit(*pos_)) {
+            return fail("Invalid number");
+        }
+        while (pos_ < end_ && isDigit(*pos_)) ++pos_;
+    }
+
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back({Type::NUMBER, index + 1, 0, ::std::string_view(start, pos_ - start)});
+    return true;
+}
+
+bool Document::parseLiteral(::std::string_view literal, Type type) {
+    if (static_cast<size_t>(end_ - pos_) < literal.size() || ::std::memcmp(pos_, literal.data(), literal.size()) != 0) {
+        return fail("Invalid literal");
+    }
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back({type, index + 1, 0, ::std::string_view(pos_, literal.size())});
+    pos_ += literal.size();
+    return true;
+}
+
+}
@@ -0,0 +1,335 @@
+#include "json_writer.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace SimpleJson {
+
+namespace {
+
+const char kReplacementChar[] = "\xEF\xBF\xBD";
+
+// Length of the well-formed UTF-8 sequence at text[i], or 0 if it is not one.
+size_t utf8SequenceLength(::std::string_view text, size_t i) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length;
+    unsigned char min = 0x80, max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) min = 0xA0;      // overlong
+        if (lead == 0xED) max = 0x9F;      // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) min = 0x90;      // overlong
+        if (lead == 0xF4) max = 0x8F;      // above U+10FFFF
+    } else {
+        return 0;
+    }
+    if (i + length > text.size()) {
+        return 0;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        unsigned char c = static_cast<unsigned char>(text[i + k]);
+        if (c < (k == 1 ? min : 0x80) || c > (k == 1 ? max : 0xBF)) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// CBOR initial bytes (RFC 8949 section 3).
+const unsigned kCborUnsigned = 0;
+const unsigned kCborNegative = 1;
+const unsigned kCborText = 3;
+const char kCborFalse = '\xF4';
+const char kCborTrue = '\xF5';
+const char kCborNull = '\xF6';
+const char kCborFloat32 = '\xFA';
+const char kCborFloat64 = '\xFB';
+const char kCborBreak = '\xFF';
+
+void appendBigEndian(::std::string& out, uint64_t bits, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+        out += static_cast<char>((bits >> (i * 8)) & 0xFF);
+    }
+}
+
+}
+
+thread_local Format Writer::current_ = Format::JSON;
+
+const char* contentType(Format format) {
+    return format == Format::CBOR ? "application/cbor" : "application/json";
+}
+
+void appendString(::std::string& out, ::std::string_view text) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    size_t runStart = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+            ++i;
+            continue;
+        }
+        if (c >= 0x80) {
+            size_t length = utf8SequenceLength(text, i);
+            if (length > 0) {
+                i += length;
+                continue;
+            }
+        }
+
+        out.append(text.data() + runStart, i - runStart);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                if (c < 0x20) {
+                    out += "\\u00";
+                    out += kHex[c >> 4];
+                    out += kHex[c & 0xF];
+                } else {
+                    out += kReplacementChar;
+                }
+        }
+        ++i;
+        runStart = i;
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+    out += '"';
+}
+
+// Shortest head for the argument, as CBOR's preferred serialization asks.
+void Writer::cborHead(unsigned major, uint64_t argument) {
+    char type = static_cast<char>(major << 5);
+    if (argument < 24) {
+        out_ += static_cast<char>(type | argument);
+    } else if (argument <= 0xFF) {
+        out_ += static_cast<char>(type | 24);
+        appendBigEndian(out_, argument, 1);
+    } else if (argument <= 0xFFFF) {
+        out_ += static_cast<char>(type | 25);
+        appendBigEndian(out_, argument, 2);
+    } else if (argument <= 0xFFFFFFFF) {
+        out_ += static_cast<char>(type | 26);
+        appendBigEndian(out_, argument, 4);
+    } else {
+        out_ += static_cast<char>(type | 27);
+        appendBigEndian(out_, argument, 8);
+    }
+}
+
+void Writer::cborString(::std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            ++i;
+        } else {
+            size_t length = utf8SequenceLength(text, i);
+            if (length == 0) {
+                break;
+            }
+            i += length;
+        }
+    }
+    if (i == text.size()) {
+        cborHead(kCborText, text.size());
+        out_.append(text.data(), text.size());
+        return;
+    }
+
+    // Text strings must be valid UTF-8; repair the rest the way appendString does.
+    ::std::string repaired(text.data(), i);
+    while (i < text.size()) {
+        size_t length = static_cast<unsigned char>(text[i]) < 0x80 ? 1 : utf8SequenceLength(text, i);
+        if (length == 0) {
+            repaired += kReplacementChar;
+            ++i;
+        } else {
+            repaired.append(text.data() + i, length);
+            i += length;
+        }
+    }
+    cborHead(kCborText, repaired.size());
+    out_ += repaired;
+}
+
+void Writer::separate() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (depth_ == 0) {
+        return;
+    }
+    uint64_t bit = uint64_t(1) << (depth_ - 1);
+    if (hasItems_ & bit) {
+        out_ += ',';
+    }
+    hasItems_ |= bit;
+}
+
+void Writer::open(char bracket) {
+    if (format_ == Format::CBOR) {
+        // Indefinite-length map or array, closed by a break byte.
+        out_ += bracket == '{' ? '\xBF' : '\x9F';
+        return;
+    }
+    separate();
+    out_ += bracket;
+    if (depth_ < kMaxDepth) {
+        ++depth_;
+        hasItems_ &= ~(uint64_t(1) << (depth_ - 1));
+    }
+}
+
+void Writer::close(char bracket) {
+    if (format_ == Format::CBOR) {
+        out_ += kCborBreak;
+        return;
+    }
+    out_ += bracket;
+    if (depth_ > 0) {
+        --depth_;
+    }
+}
+
+Writer& Writer::beginObject() {
+    open('{');
+    return *this;
+}
+
+Writer& Writer::endObject() {
+    close('}');
+    return *this;
+}
+
+Writer& Writer::beginArray() {
+    open('[');
+    return *this;
+}
+
+Writer& Writer::endArray() {
+    close(']');
+    return *this;
+}
+
+Writer& Writer::key(::std::string_view name) {
+    if (format_ == Format::CBOR) {
+        cborString(name);
+        return *this;
+    }
+    separate();
+    appendString(out_, name);
+    out_ += ':';
+    afterKey_ = true;
+    return *this;
+}
+
+Writer& Writer::value(::std::string_view text) {
+    if (format_ == Format::CBOR) {
+        cborString(text);
+        return *this;
+    }
+    separate();
+    appendString(out_, text);
+    return *this;
+}
+
+Writer& Writer::value(bool flag) {
+    if (format_ == Format::CBOR) {
+        out_ += flag ? kCborTrue : kCborFalse;
+        return *this;
+    }
+    separate();
+    out_ += flag ? "true" : "false";
+    return *this;
+}
+
+Writer& Writer::value(long long number) {
+    if (format_ == Format::CBOR) {
+        if (number >= 0) {
+            cborHead(kCborUnsigned, static_cast<uint64_t>(number));
+        } else {
+            cborHead(kCborNegative, static_cast<uint64_t>(-1 - number));
+        }
+        return *this;
+    }
+    separate();
+    char digits[24];
+    out_.append(digits, ::std::to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+    return *this;
+}
+
+Writer& Writer::value(unsigned long long number) {
+    if (format_ == Format::CBOR) {
+        cborHead(kCborUnsigned, number);
+        return *this;
+    }
+    separate();
+    char digits[24];
+    out_.append(digits, ::std::to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+    return *this;
+}
+
+Writer& Writer::value(double number) {
+    if (!::std::isfinite(number)) {
+        return null();
+    }
+    if (format_ == Format::CBOR) {
+        float narrow = static_cast<float>(number);
+        if (static_cast<double>(narrow) == number) {
+            uint32_t bits;
+            ::std::memcpy(&bits, &narrow, sizeof(bits));
+            out_ += kCborFloat32;
+            appendBigEndian(out_, bits, 4);
+        } else {
+            uint64_t bits;
+            ::std::memcpy(&bits, &number, sizeof(bits));
+            out_ += kCborFloat64;
+            appendBigEndian(out_, bits, 8);
+        }
+        return *this;
+    }
+    separate();
+    char digits[32];
+    out_.append(digits, ::std::to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+    return *this;
+}
+
+Writer& Writer::null() {
+    if (format_ == Format::CBOR) {
+        out_ += kCborNull;
+        return *this;
+    }
+    separate();
+    out_ += "null";
+    return *this;
+}
+
+Writer& Writer::raw(::std::string_view encoded) {
+    if (format_ != Format::CBOR) {
+        separate();
+    }
+    out_.append(encoded.data(), encoded.size());
+    return *this;
+}
+
+Writer& Writer::array(const int* values, size_t count) {
+    beginArray();
+    for (size_t i = 0; i < count; ++i) {
+        value(values[i]);
+    }
+    return endArray();
+}
+
+}
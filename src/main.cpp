@@ -1,291 +1,334 @@
 #include "memory_service.h"
 #include "user_service.h"
 #include "api_controller.h"
+#include "http_server.h"
+#include "static_files.h"
+#include "router.h"
+#include "rate_limiter.h"
+#include "websocket.h"
+#include "compression.h"
+#include "json_writer.h"
+#include "json_reader.h"
 #include <iostream>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <thread>
-#include <chrono>
-#include <fstream>
 #include <map>
+#include <algorithm>
 #include <exception>
 #include <stdexcept>
+#include <charconv>
+#include <cstdlib>
 
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <sys/time.h>
-#include <unistd.h>
-#include <cstring>
-#include <regex>
+struct AppOptions {
+    SimpleHttp::ServerConfig server;
+    bool watchStatic = false;
+    size_t rateLimiterCapacity = 64 * 1024;
+    ::std::map<::std::string, SimpleHttp::RateLimit> rateLimits;
+    ::std::map<MemoryTrainer::GameType, int> gameTtls;
+    int reapIntervalMs = 1000;
+    size_t readyGames = 64;
+};
 
-namespace SimpleHttp {
-    struct Request {
-        ::std::string method;
-        ::std::string path;
-        ::std::string body;
-        ::std::map<::std::string, ::std::string> queryParams;
-    };
-    
-    struct Response {
-        int statusCode = 200;
-        ::std::string body;
-        ::std::map<::std::string, ::std::string> headers;
-        
-        ::std::string toString() const {
-            ::std::ostringstream oss;
-            oss << "HTTP/1.1 " << statusCode << " OK\r\n";
-            
-            if (headers.count("Content-Type")) {
-                oss << "Content-Type: " << headers.at("Content-Type") << "\r\n";
-            } else {
-                oss << "Content-Type: application/json\r\n";
-            }
-            oss << "Access-Control-Allow-Origin: *\r\n";
-            oss << "Content-Length: " << body.length() << "\r\n";
-            oss << "\r\n";
-            oss << body;
-            return oss.str();
+// TYPE:SECONDS with TYPE sequence or cards.
+static void parseGameTtl(const ::std::string& spec, AppOptions& options) {
+    size_t colon = spec.find(':');
+    ::std::string type = spec.substr(0, colon);
+    MemoryTrainer::GameType gameType;
+    if (type == "sequence" || type == "numbers") {
+        gameType = MemoryTrainer::GameType::SEQUENCE;
+    } else if (type == "cards" || type == "pairs") {
+        gameType = MemoryTrainer::GameType::PAIRS;
+    } else {
+        ::std::cerr << "Invalid game TTL: " << spec << ::std::endl;
+        return;
+    }
+    if (colon == ::std::string::npos) {
+        ::std::cerr << "Invalid game TTL: " << spec << ::std::endl;
+        return;
+    }
+    options.gameTtls[gameType] = ::std::stoi(spec.substr(colon + 1));
+}
+
+// CLASS:RPS[:BURST]; burst defaults to twice the rate.
+static void parseRateLimit(const ::std::string& spec, AppOptions& options) {
+    size_t first = spec.find(':');
+    if (first == ::std::string::npos || first == 0) {
+        ::std::cerr << "Invalid rate limit: " << spec << ::std::endl;
+        return;
+    }
+    size_t second = spec.find(':', first + 1);
+    SimpleHttp::RateLimit limit;
+    limit.requestsPerSecond = ::std::stod(spec.substr(first + 1, second - first - 1));
+    limit.burst = second == ::std::string::npos ? limit.requestsPerSecond * 2 : ::std::stod(spec.substr(second + 1));
+    options.rateLimits[spec.substr(0, first)] = limit;
+}
+
+static AppOptions parseOptions(int argc, char* argv[]) {
+    AppOptions options;
+    SimpleHttp::ServerConfig& config = options.server;
+    for (int i = 1; i < argc; ++i) {
+        ::std::string arg = argv[i];
+        if (arg == "--io=threads") {
+            config.ioModel = SimpleHttp::IoModel::THREAD_POOL;
+        } else if (arg == "--io=epoll") {
+            config.ioModel = SimpleHttp::IoModel::EPOLL;
+        } else if (arg == "--io=uring") {
+            config.ioModel = SimpleHttp::IoModel::IO_URING;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            config.eventLoopThreads = ::std::stoi(arg.substr(10));
+        } else if (arg.rfind("--workers=", 0) == 0) {
+            config.workerThreads = ::std::stoi(arg.substr(10));
+        } else if (arg.rfind("--queue=", 0) == 0) {
+            config.maxQueuedConnections = ::std::stoul(arg.substr(8));
+        } else if (arg.rfind("--reuseport=", 0) == 0) {
+            config.reusePortListeners = ::std::stoi(arg.substr(12));
+        } else if (arg.rfind("--backlog=", 0) == 0) {
+            config.listenBacklog = ::std::stoi(arg.substr(10));
+        } else if (arg.rfind("--keepalive-timeout=", 0) == 0) {
+            config.keepAliveTimeoutMs = ::std::stoi(arg.substr(20));
+        } else if (arg.rfind("--header-timeout=", 0) == 0) {
+            config.headerTimeoutMs = ::std::stoi(arg.substr(17));
+        } else if (arg.rfind("--body-timeout=", 0) == 0) {
+            config.bodyTimeoutMs = ::std::stoi(arg.substr(15));
+        } else if (arg.rfind("--write-timeout=", 0) == 0) {
+            config.writeTimeoutMs = ::std::stoi(arg.substr(16));
+        } else if (arg.rfind("--max-requests=", 0) == 0) {
+            config.maxRequestsPerConnection = ::std::stoi(arg.substr(15));
+        } else if (arg.rfind("--gzip-level=", 0) == 0) {
+            config.compressionLevel = ::std::stoi(arg.substr(13));
+        } else if (arg.rfind("--gzip-min-size=", 0) == 0) {
+            config.compressionMinSize = ::std::stoul(arg.substr(16));
+        } else if (arg.rfind("--rate-limit=", 0) == 0) {
+            parseRateLimit(arg.substr(13), options);
+        } else if (arg.rfind("--rate-limit-capacity=", 0) == 0) {
+            options.rateLimiterCapacity = ::std::stoul(arg.substr(22));
+        } else if (arg.rfind("--game-ttl=", 0) == 0) {
+            parseGameTtl(arg.substr(11), options);
+        } else if (arg.rfind("--reap-interval=", 0) == 0) {
+            options.reapIntervalMs = ::std::stoi(arg.substr(16));
+        } else if (arg.rfind("--ready-games=", 0) == 0) {
+            options.readyGames = ::std::stoul(arg.substr(14));
+        } else if (arg == "--watch-static") {
+            options.watchStatic = true;
+        } else {
+            ::std::cerr << "Unknown option: " << arg << ::std::endl;
         }
-    };
-    
-    class Server {
-    public:
-        Server(int port) : port_(port), running_(false) {}
-        
-        void start(::std::function<Response(const Request&)> handler) {
-            handler_ = handler;
-            running_ = true;
-            
-            int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-            if (serverSocket < 0) {
-                ::std::cerr << "Error creating socket" << ::std::endl;
-                return;
-            }
-            
-            int opt = 1;
-            setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-            
-            sockaddr_in address{};
-            address.sin_family = AF_INET;
-            address.sin_addr.s_addr = INADDR_ANY;
-            address.sin_port = htons(port_);
-            
-            if (bind(serverSocket, (struct sockaddr*)&address, sizeof(address)) < 0) {
-                ::std::cerr << "Error binding socket" << ::std::endl;
-                close(serverSocket);
-                return;
-            }
-            
-            if (listen(serverSocket, 10) < 0) {
-                ::std::cerr << "Error listening" << ::std::endl;
-                close(serverSocket);
-                return;
-            }
-            
-            ::std::cout << "Server started on port " << port_ << ::std::endl;
-            
-            while (running_) {
-                sockaddr_in clientAddress{};
-                socklen_t clientLen = sizeof(clientAddress);
-                int clientSocket = accept(serverSocket, (struct sockaddr*)&clientAddress, &clientLen);
-                
-                if (clientSocket < 0) {
-                    continue;
-                }
-                
-                ::std::thread([this, clientSocket]() {
-                    handleClient(clientSocket);
-                }).detach();
-            }
-            
-            close(serverSocket);
+    }
+    return options;
+}
+
+// Parses a body that must be a JSON object; otherwise res becomes a 400 naming the problem.
+static bool parseJsonBody(const SimpleHttp::Request& req, SimpleJson::Document& doc, SimpleHttp::Response& res) {
+    if (doc.parse(req.body) && doc.root().isObject()) {
+        return true;
+    }
+    res.statusCode = 400;
+    SimpleJson::Writer json(res.body);
+    json.beginObject().field("error", "Invalid JSON body");
+    if (doc.error()) {
+        json.field("detail", doc.error()).field("offset", doc.errorOffset());
+    } else {
+        json.field("detail", "Expected an object");
+    }
+    json.endObject();
+    return false;
+}
+
+static void setError(SimpleHttp::Response& res, ::std::string_view message) {
+    SimpleJson::Writer(res.body).beginObject().field("error", message).endObject();
+}
+
+// q-value the Accept header gives mediaType, or -1 when it is not listed.
+// Wildcards count only when allowWildcards is set.
+static double acceptQuality(::std::string_view accept, ::std::string_view mediaType, bool allowWildcards) {
+    ::std::string_view typeWildcard = mediaType.substr(0, mediaType.find('/') + 1);
+    double best = -1;
+    while (!accept.empty()) {
+        size_t comma = accept.find(',');
+        ::std::string_view item = accept.substr(0, comma);
+        accept = comma == ::std::string_view::npos ? ::std::string_view() : accept.substr(comma + 1);
+
+        size_t semi = item.find(';');
+        ::std::string_view range = item.substr(0, semi);
+        while (!range.empty() && (range.front() == ' ' || range.front() == '\t')) range.remove_prefix(1);
+        while (!range.empty() && (range.back() == ' ' || range.back() == '\t')) range.remove_suffix(1);
+
+        bool matches = range == mediaType;
+        if (allowWildcards && !matches) {
+            matches = range == "*/*" ||
+                      (range.size() == typeWildcard.size() + 1 && range.back() == '*' &&
+                       range.compare(0, typeWildcard.size(), typeWildcard) == 0);
         }
-        
-        void stop() {
-            running_ = false;
+        if (!matches) {
+            continue;
         }
-        
-    private:
-        void handleClient(int clientSocket) {
-            
-            struct timeval timeout;
-            timeout.tv_sec = 5;
-            timeout.tv_usec = 0;
-            setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-            
-            ::std::string requestData;
-            char buffer[8192] = {0};
-            
-            
-            ssize_t totalRead = 0;
-            bool headersComplete = false;
-            
-            while (totalRead < 8191 && !headersComplete) {
-                ssize_t bytesRead = recv(clientSocket, buffer + totalRead, 8191 - totalRead, 0);
-                if (bytesRead <= 0) {
-                    close(clientSocket);
-                    return;
-                }
-                totalRead += bytesRead;
-                buffer[totalRead] = '\0';
-                
-                
-                ::std::string currentData(buffer, totalRead);
-                size_t headerEnd = currentData.find("\r\n\r\n");
-                if (headerEnd != ::std::string::npos) {
-                    headersComplete = true;
-                    requestData = currentData;
-                }
-            }
-            
-            if (!headersComplete) {
-                requestData = ::std::string(buffer, totalRead);
-            }
-            
-            
-            size_t contentLength = 0;
-            size_t headerEnd = requestData.find("\r\n\r\n");
-            if (headerEnd != ::std::string::npos) {
-                ::std::string headers = requestData.substr(0, headerEnd);
-                size_t clPos = headers.find("Content-Length:");
-                if (clPos != ::std::string::npos) {
-                    size_t clStart = headers.find(":", clPos) + 1;
-                    size_t clEnd = headers.find("\r\n", clStart);
-                    if (clEnd == ::std::string::npos) clEnd = headers.length();
-                    ::std::string clStr = headers.substr(clStart, clEnd - clStart);
-                    
-                    clStr.erase(0, clStr.find_first_not_of(" \t"));
-                    size_t lastNonSpace = clStr.find_last_not_of(" \t");
-                    if (lastNonSpace != ::std::string::npos) {
-                        clStr = clStr.substr(0, lastNonSpace + 1);
-                    }
-                    if (!clStr.empty()) {
-                        try {
-                            contentLength = ::std::stoul(clStr);
-                        } catch (...) {
-                            contentLength = 0;
-                        }
-                    }
-                }
-                
-                
-                ::std::string body = requestData.substr(headerEnd + 4);
-                size_t bodyRead = body.length();
-                
-                
-                while (bodyRead < contentLength && bodyRead < 8192) {
-                    char bodyBuffer[1024] = {0};
-                    size_t toRead = (contentLength - bodyRead < 1024) ? (contentLength - bodyRead) : 1024;
-                    ssize_t bytesRead = recv(clientSocket, bodyBuffer, toRead, 0);
-                    if (bytesRead <= 0) {
-                        
-                        break;
-                    }
-                    body.append(bodyBuffer, bytesRead);
-                    bodyRead += bytesRead;
-                }
-                
-                requestData = headers + "\r\n\r\n" + body;
-            }
-            
-            Request req = parseRequest(requestData);
-            Response res;
-            
-            try {
-                res = handler_(req);
-            } catch (const ::std::exception& e) {
-                ::std::cerr << "Exception in handler: " << e.what() << ::std::endl;
-                ::std::cerr << "Request path: " << req.path << ::std::endl;
-                res.statusCode = 500;
-                res.body = "{\"error\":\"Internal server error\"}";
-            } catch (...) {
-                ::std::cerr << "Unknown exception in handler" << ::std::endl;
-                ::std::cerr << "Request path: " << req.path << ::std::endl;
-                res.statusCode = 500;
-                res.body = "{\"error\":\"Internal server error\"}";
-            }
-            
-            
-            if (res.body.find("{") == 0 || res.body.find("[") == 0) {
-                res.headers["Content-Type"] = "application/json";
-            }
-            res.headers["Access-Control-Allow-Origin"] = "*";
-            
-            ::std::string responseStr = res.toString();
-            ssize_t sent = send(clientSocket, responseStr.c_str(), responseStr.length(), 0);
-            if (sent < 0) {
-                ::std::cerr << "Error sending response" << ::std::endl;
-            } else {
-                
-                size_t totalSent = sent;
-                while (totalSent < responseStr.length()) {
-                    ssize_t bytesSent = send(clientSocket, responseStr.c_str() + totalSent, 
-                                            responseStr.length() - totalSent, 0);
-                    if (bytesSent <= 0) break;
-                    totalSent += bytesSent;
-                }
+
+        double quality = 1;
+        if (semi != ::std::string_view::npos) {
+            size_t q = item.find("q=", semi);
+            if (q != ::std::string_view::npos) {
+                ::std::string value(item.substr(q + 2));
+                quality = ::std::strtod(value.c_str(), nullptr);
             }
-            
-            
-            shutdown(clientSocket, SHUT_WR);
-            close(clientSocket);
         }
-        
-        Request parseRequest(const ::std::string& raw) {
-            Request req;
-            
-            
-            size_t headerEnd = raw.find("\r\n\r\n");
-            if (headerEnd == ::std::string::npos) {
-                headerEnd = raw.find("\n\n");
-            }
-            
-            ::std::string headers;
-            if (headerEnd != ::std::string::npos) {
-                headers = raw.substr(0, headerEnd);
-                req.body = raw.substr(headerEnd + (raw.find("\r\n\r\n") != ::std::string::npos ? 4 : 2));
-            } else {
-                headers = raw;
-            }
-            
-            
-            size_t firstLineEnd = headers.find("\r\n");
-            if (firstLineEnd == ::std::string::npos) {
-                firstLineEnd = headers.find("\n");
-            }
-            if (firstLineEnd != ::std::string::npos) {
-                ::std::string firstLine = headers.substr(0, firstLineEnd);
-                ::std::istringstream firstLineStream(firstLine);
-                firstLineStream >> req.method >> req.path;
+        best = ::std::max(best, quality);
+    }
+    return best;
+}
+
+// API responses are CBOR when the client names application/cbor at least as
+// highly as JSON; wildcards alone keep JSON.
+static SimpleJson::Format negotiateFormat(const SimpleHttp::Request& req) {
+    ::std::string_view accept = req.header("Accept");
+    if (accept.empty() || req.path.compare(0, 5, "/api/") != 0) {
+        return SimpleJson::Format::JSON;
+    }
+    double cbor = acceptQuality(accept, "application/cbor", false);
+    if (cbor > 0 && cbor >= acceptQuality(accept, "application/json", true)) {
+        return SimpleJson::Format::CBOR;
+    }
+    return SimpleJson::Format::JSON;
+}
+
+// ?since=VERSION asks card game responses for only the cards changed after
+// that version; absent or malformed means the full card list.
+static int64_t sinceParam(const SimpleHttp::Request& req) {
+    ::std::string_view text = req.query("since");
+    int64_t since = -1;
+    auto result = ::std::from_chars(text.data(), text.data() + text.size(), since);
+    if (result.ec != ::std::errc() || result.ptr != text.data() + text.size()) {
+        return -1;
+    }
+    return since;
+}
+
+static const size_t kMaxBatchMoves = 256;
+
+// [{"type":"flip","cardId":3},{"type":"check-pair","cardId1":3,"cardId2":5},...]
+static bool parseCardMoves(SimpleJson::Value list, ::std::vector<MemoryTrainer::CardMove>& moves) {
+    using MemoryTrainer::CardMove;
+    if (!list.isArray() || list.size() > kMaxBatchMoves) {
+        return false;
+    }
+    moves.reserve(list.size());
+    for (SimpleJson::Value move : list) {
+        ::std::string_view type = move["type"].asString();
+        if (type == "flip") {
+            moves.push_back({CardMove::Kind::FLIP, move["cardId"].asInt(-1), -1});
+            if (moves.back().cardId1 < 0) return false;
+        } else if (type == "check-pair") {
+            moves.push_back({CardMove::Kind::CHECK_PAIR, move["cardId1"].asInt(-1), move["cardId2"].asInt(-1)});
+            if (moves.back().cardId1 < 0 || moves.back().cardId2 < 0) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One card game played over a WebSocket: {"type":"flip","cardId":N},
+// {"type":"check-pair","cardId1":N,"cardId2":M} and {"type":"state"}.
+class CardGameChannel : public SimpleHttp::WebSocketHandler {
+public:
+    CardGameChannel(MemoryTrainer::ApiController& controller, ::std::string gameId, ::std::string sessionId)
+        : controller_(controller), gameId_(::std::move(gameId)), sessionId_(::std::move(sessionId)) {}
+
+    ::std::string onMessage(::std::string_view message) override {
+        using MemoryTrainer::ApiControllerAccess;
+        SimpleJson::FormatScope textFrames(SimpleJson::Format::JSON);
+        SimpleJson::Document doc;
+        doc.parse(message);
+        ::std::string_view type = doc["type"].asString();
+        if (type == "flip") {
+            int cardId = doc["cardId"].asInt(-1);
+            if (cardId >= 0) {
+                return ApiControllerAccess::flipCardUpdate(controller_, gameId_, cardId);
             }
-            
-            
-            size_t qPos = req.path.find('?');
-            if (qPos != ::std::string::npos) {
-                ::std::string query = req.path.substr(qPos + 1);
-                req.path = req.path.substr(0, qPos);
-                
-                ::std::regex paramRegex("([^=&]+)=([^&]*)");
-                ::std::sregex_iterator iter(query.begin(), query.end(), paramRegex);
-                ::std::sregex_iterator end;
-                
-                for (; iter != end; ++iter) {
-                    req.queryParams[iter->str(1)] = iter->str(2);
-                }
+        } else if (type == "check-pair") {
+            int cardId1 = doc["cardId1"].asInt(-1);
+            int cardId2 = doc["cardId2"].asInt(-1);
+            if (cardId1 >= 0 && cardId2 >= 0) {
+                return ApiControllerAccess::checkCardPairUpdate(controller_, gameId_, cardId1, cardId2, sessionId_);
             }
-            
-            return req;
+        } else if (type == "state") {
+            return ApiControllerAccess::getGame(controller_, gameId_);
         }
-        
-        int port_;
-        bool running_;
-        ::std::function<Response(const Request&)> handler_;
-    };
+        return "{\"type\":\"error\",\"error\":\"Invalid message\"}";
+    }
+
+private:
+    MemoryTrainer::ApiController& controller_;
+    ::std::string gameId_;
+    ::std::string sessionId_;
+};
+
+static void writeServerStats(SimpleJson::Writer& json, const SimpleHttp::ServerStats& stats) {
+    json.beginObject()
+        .field("acceptedConnections", stats.acceptedConnections)
+        .field("rejectedConnections", stats.rejectedConnections)
+        .field("timedOutConnections", stats.timedOutConnections)
+        .field("activeConnections", stats.activeConnections)
+        .field("queueDepth", stats.queueDepth)
+        .field("queueCapacity", stats.queueCapacity)
+        .key("listeners").beginArray();
+    for (const auto& listener : stats.listeners) {
+        json.beginObject()
+            .field("acceptedConnections", listener.acceptedConnections)
+            .field("activeConnections", listener.activeConnections)
+            .endObject();
+    }
+    json.endArray().endObject();
+}
+
+static void writeRateLimiterStats(SimpleJson::Writer& json, const SimpleHttp::RateLimiterStats& stats) {
+    json.beginObject()
+        .field("allowed", stats.allowed)
+        .field("limited", stats.limited)
+        .field("evicted", stats.evicted)
+        .field("capacity", stats.capacity)
+        .endObject();
+}
+
+static void writeGamePoolStats(SimpleJson::Writer& json, const MemoryTrainer::GamePoolStats& stats) {
+    json.beginObject()
+        .field("capacity", stats.capacity)
+        .field("inUse", stats.inUse)
+        .field("highWater", stats.highWater)
+        .field("acquired", stats.acquired)
+        .field("reused", stats.reused)
+        .endObject();
+}
+
+static void writeGameStats(SimpleJson::Writer& json, const MemoryTrainer::GameStats& stats) {
+    json.beginObject()
+        .field("active", stats.active)
+        .field("shards", stats.shards)
+        .field("created", stats.created)
+        .field("deleted", stats.deleted)
+        .field("expired", stats.expired)
+        .key("pools").beginObject().key("sequence");
+    writeGamePoolStats(json, stats.sequencePool);
+    json.key("cards");
+    writeGamePoolStats(json, stats.cardPool);
+    json.endObject().key("ready").beginArray();
+    for (const auto& pool : stats.ready) {
+        static const char* const difficulties[] = {"easy", "medium", "hard"};
+        json.beginObject()
+            .field("type", pool.type == MemoryTrainer::GameType::PAIRS ? "cards" : "sequence")
+            .field("difficulty", difficulties[static_cast<size_t>(pool.difficulty)])
+            .field("ready", pool.ready)
+            .field("target", pool.target)
+            .field("createRate", pool.createRate)
+            .field("hits", pool.hits)
+            .field("misses", pool.misses)
+            .field("refillLagMs", pool.refillLagMs)
+            .field("maxRefillLagMs", pool.maxRefillLagMs)
+            .endObject();
+    }
+    json.endArray().endObject();
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     using namespace MemoryTrainer;
     using namespace SimpleHttp;
     
@@ -293,273 +336,293 @@ int main() {
     UserService userService;
     ApiController controller(service, userService);
     
-    Server server(8080);
+    AppOptions options = parseOptions(argc, argv);
+    for (const auto& entry : options.gameTtls) {
+        service.setIdleTtl(entry.first, entry.second);
+    }
+    service.startReaper(options.reapIntervalMs);
+    service.startProducer(options.readyGames);
+    
+    StaticFileCache staticFiles(StaticFileCache::resolveRoot({"web", "../web", "../../web"}));
+    staticFiles.alias("/", "/web/index.html");
+    staticFiles.alias("/index.html", "/web/index.html");
+    staticFiles.alias("/leaderboard.html", "/web/leaderboard.html");
+    if (options.watchStatic) {
+        staticFiles.watch();
+    }
+    ::std::cout << "Serving " << staticFiles.fileCount() << " static files from " << staticFiles.root() << ::std::endl;
+    
+    // First matching rule wins; static files are not limited.
+    RateLimiter rateLimiter(options.rateLimiterCapacity);
+    rateLimiter.setClass("auth", {5, 10});
+    rateLimiter.setClass("create", {10, 20});
+    rateLimiter.setClass("api", {50, 100});
+    for (const auto& entry : options.rateLimits) {
+        rateLimiter.setClass(entry.first, entry.second);
+    }
+    rateLimiter.assign("POST", "/api/login", "auth");
+    rateLimiter.assign("POST", "/api/register", "auth");
+    rateLimiter.assign("POST", "/api/game", "create");
+    rateLimiter.assign("", "/api/*", "api");
+    
+    Router router;
     
-    server.start([&controller](const Request& req) -> Response {
+    router.post("/api/register", [&controller](const Request& req, const RouteParams&) -> Response {
         Response res;
-
-        if (req.method == "OPTIONS") {
-            res.statusCode = 200;
-            res.headers["Access-Control-Allow-Methods"] = "GET, POST, DELETE, OPTIONS";
-            res.headers["Access-Control-Allow-Headers"] = "Content-Type, Authorization";
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
+        }
+        ::std::string username(body["username"].asString());
+        ::std::string email(body["email"].asString());
+        ::std::string password(body["password"].asString());
+        res.body = ApiControllerAccess::registerUser(controller, username, email, password);
+        return res;
+    });
+    
+    router.post("/api/login", [&controller](const Request& req, const RouteParams&) -> Response {
+        Response res;
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
+        }
+        ::std::string username(body["username"].asString());
+        ::std::string password(body["password"].asString());
+        res.body = ApiControllerAccess::loginUser(controller, username, password);
+        return res;
+    });
+    
+    router.post("/api/logout", [&controller](const Request& req, const RouteParams&) -> Response {
+        Response res;
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
+        }
+        ::std::string sessionId(body["sessionId"].asString());
+        res.body = ApiControllerAccess::logoutUser(controller, sessionId);
+        return res;
+    });
+    
+    router.get("/api/user", [&controller](const Request& req, const RouteParams&) -> Response {
+        Response res;
+        ::std::string sessionId(req.query("sessionId"));
+        res.body = ApiControllerAccess::getUser(controller, sessionId);
+        return res;
+    });
+    
+    router.get("/api/leaderboard", [&controller](const Request& req, const RouteParams&) -> Response {
+        Response res;
+        ::std::string_view limitParam = req.query("limit");
+        int limit = 20;
+        ::std::from_chars(limitParam.data(), limitParam.data() + limitParam.size(), limit);
+        ::std::string leaderboardData = ApiControllerAccess::getLeaderboard(controller, limit);
+        res.body.reserve(leaderboardData.size() + 16);
+        SimpleJson::Writer(res.body).beginObject().key("leaderboard").raw(leaderboardData).endObject();
+        return res;
+    });
+    
+    Server server(8080, options.server);
+    server.setRateLimiter(&rateLimiter);
+    
+    router.get("/api/metrics", [&server, &rateLimiter, &service](const Request&, const RouteParams&) -> Response {
+        Response res;
+        SimpleJson::Writer json(res.body);
+        json.beginObject().key("server");
+        writeServerStats(json, server.stats());
+        json.key("rateLimiter");
+        writeRateLimiterStats(json, rateLimiter.stats());
+        json.key("games");
+        writeGameStats(json, service.stats());
+        json.endObject();
+        return res;
+    });
+    
+    router.post("/api/game", [&controller](const Request& req, const RouteParams&) -> Response {
+        Response res;
+        ::std::string type(req.query("type", "sequence"));
+        ::std::string difficulty(req.query("difficulty", "medium"));
+        res.body = ApiControllerAccess::createGame(controller, type, difficulty, "");
+        return res;
+    });
+    
+    router.get("/api/game/{id}", [&controller, &options](const Request& req, const RouteParams& params) -> Response {
+        Response res;
+        ::std::string gameId(params.get("id"));
+        int64_t since = sinceParam(req);
+        if (since >= 0) {
+            res.body = ApiControllerAccess::getGame(controller, gameId, since);
             return res;
         }
         
-        
-        if (req.path == "/api/register" && req.method == "POST") {
-            ::std::string username, email, password;
-            ::std::string cleanBody = req.body;
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\n'), cleanBody.end());
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\r'), cleanBody.end());
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\t'), cleanBody.end());
-            
-            ::std::regex usernameRegex("\"username\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::regex emailRegex("\"email\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::regex passwordRegex("\"password\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::smatch match;
-            
-            if (::std::regex_search(cleanBody, match, usernameRegex)) username = match[1].str();
-            if (::std::regex_search(cleanBody, match, emailRegex)) email = match[1].str();
-            if (::std::regex_search(cleanBody, match, passwordRegex)) password = match[1].str();
-            
-            res.body = ApiControllerAccess::registerUser(controller, username, email, password);
+        // Polling clients get the cached body, already gzipped if they accept it,
+        // or a 304 if they already have it.
+        auto snapshot = ApiControllerAccess::gameSnapshot(controller, gameId, options.server.compressionLevel,
+                                                          options.server.compressionMinSize);
+        if (!snapshot) {
+            setError(res, "Game not found");
+            return res;
         }
-        else if (req.path == "/api/login" && req.method == "POST") {
-            ::std::string username, password;
-            ::std::string cleanBody = req.body;
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\n'), cleanBody.end());
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\r'), cleanBody.end());
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\t'), cleanBody.end());
-            
-            ::std::regex usernameRegex("\"username\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::regex passwordRegex("\"password\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::smatch match;
-            
-            if (::std::regex_search(cleanBody, match, usernameRegex)) username = match[1].str();
-            if (::std::regex_search(cleanBody, match, passwordRegex)) password = match[1].str();
-            
-            res.body = ApiControllerAccess::loginUser(controller, username, password);
+        bool gzip = !snapshot->gzipBody.empty() && acceptsGzip(req);
+        const ::std::string& etag = gzip ? snapshot->gzipEtag : snapshot->etag;
+        res.headers["ETag"] = etag;
+        res.headers["Cache-Control"] = "no-cache";
+        res.headers["Vary"] = "Accept-Encoding";
+        if (req.hasHeader("If-None-Match") && etagMatches(req.header("If-None-Match"), etag)) {
+            res.statusCode = 304;
+            return res;
         }
-        else if (req.path == "/api/logout" && req.method == "POST") {
-            ::std::string sessionId;
-            ::std::string cleanBody = req.body;
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\n'), cleanBody.end());
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\r'), cleanBody.end());
-            cleanBody.erase(::std::remove(cleanBody.begin(), cleanBody.end(), '\t'), cleanBody.end());
-            ::std::regex sessionRegex("\"sessionId\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::smatch match;
-            if (::std::regex_search(cleanBody, match, sessionRegex)) sessionId = match[1].str();
-            res.body = ApiControllerAccess::logoutUser(controller, sessionId);
+        if (gzip) {
+            res.headers["Content-Encoding"] = "gzip";
+            res.shared = {snapshot->gzipBody, snapshot};
+        } else {
+            res.shared = {snapshot->body, snapshot};
         }
-        else if (req.path == "/api/user" && req.method == "GET") {
-            ::std::string sessionId = req.queryParams.count("sessionId") ? req.queryParams.at("sessionId") : "";
-            res.body = ApiControllerAccess::getUser(controller, sessionId);
+        return res;
+    });
+    
+    router.del("/api/game/{id}", [&controller](const Request&, const RouteParams& params) -> Response {
+        Response res;
+        ::std::string gameId(params.get("id"));
+        res.body = ApiControllerAccess::deleteGame(controller, gameId);
+        return res;
+    });
+    
+    router.post("/api/game/{id}/flip", [&controller](const Request& req, const RouteParams& params) -> Response {
+        Response res;
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
         }
-        else if (req.path == "/api/leaderboard" && req.method == "GET") {
-            int limit = req.queryParams.count("limit") ? ::std::stoi(req.queryParams.at("limit")) : 20;
-            ::std::string leaderboardData = ApiControllerAccess::getLeaderboard(controller, limit);
-            res.body = "{\"leaderboard\":" + leaderboardData + "}";
+        ::std::string gameId(params.get("id"));
+        int cardId = body["cardId"].asInt(-1);
+        
+        if (cardId >= 0) {
+            res.body = ApiControllerAccess::flipCard(controller, gameId, cardId, sinceParam(req));
+        } else {
+            setError(res, "Invalid cardId");
         }
-        else if (req.path == "/api/game" && req.method == "POST") {
-            ::std::string type = req.queryParams.count("type") ? req.queryParams.at("type") : "sequence";
-            ::std::string difficulty = req.queryParams.count("difficulty") ? req.queryParams.at("difficulty") : "medium";
-            res.body = ApiControllerAccess::createGame(controller, type, difficulty, "");
+        return res;
+    });
+    
+    router.post("/api/game/{id}/check-pair", [&controller](const Request& req, const RouteParams& params) -> Response {
+        Response res;
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
         }
-        else if (req.path.find("/api/game/") == 0 && req.method == "GET") {
-            ::std::string gameId = req.path.substr(10); 
-            res.body = ApiControllerAccess::getGame(controller, gameId);
+        ::std::string gameId(params.get("id"));
+        int cardId1 = body["cardId1"].asInt(-1);
+        int cardId2 = body["cardId2"].asInt(-1);
+        ::std::string sessionId(body["sessionId"].asString());
+        
+        if (cardId1 >= 0 && cardId2 >= 0) {
+            res.body = ApiControllerAccess::checkCardPair(controller, gameId, cardId1, cardId2, sessionId, sinceParam(req));
+        } else {
+            setError(res, "Invalid cardIds");
         }
-        else if (req.path.find("/api/game/") == 0 && req.path.find("/flip") != ::std::string::npos && req.method == "POST") {
-            size_t gameIdStart = 10;
-            size_t gameIdEnd = req.path.find("/flip");
-            ::std::string gameId = req.path.substr(gameIdStart, gameIdEnd - gameIdStart);
-            
-            ::std::regex cardRegex("\"cardId\"\\s*:\\s*(\\d+)");
-            ::std::smatch match;
-            int cardId = -1;
-            if (::std::regex_search(req.body, match, cardRegex)) {
-                cardId = ::std::stoi(match[1].str());
-            }
-            
-            if (cardId >= 0) {
-                res.body = ApiControllerAccess::flipCard(controller, gameId, cardId);
-            } else {
-                res.body = "{\"error\":\"Invalid cardId\"}";
-            }
+        return res;
+    });
+    
+    router.post("/api/game/{id}/moves", [&controller](const Request& req, const RouteParams& params) -> Response {
+        Response res;
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
         }
-        else if (req.path.find("/api/game/") == 0 && req.path.find("/check-pair") != ::std::string::npos && req.method == "POST") {
-            size_t gameIdStart = 10;
-            size_t gameIdEnd = req.path.find("/check-pair");
-            ::std::string gameId = req.path.substr(gameIdStart, gameIdEnd - gameIdStart);
-            
-            int cardId1 = -1, cardId2 = -1;
-            ::std::string sessionId = "";
-            
-            ::std::regex card1Regex("\"cardId1\"\\s*:\\s*(\\d+)");
-            ::std::regex card2Regex("\"cardId2\"\\s*:\\s*(\\d+)");
-            ::std::regex sessionRegex("\"sessionId\"\\s*:\\s*\"([^\"]+)\"");
-            ::std::smatch match;
-            if (::std::regex_search(req.body, match, card1Regex)) {
-                cardId1 = ::std::stoi(match[1].str());
-            }
-            if (::std::regex_search(req.body, match, card2Regex)) {
-                cardId2 = ::std::stoi(match[1].str());
-            }
-            if (::std::regex_search(req.body, match, sessionRegex)) {
-                sessionId = match[1].str();
-            }
-            
-            if (cardId1 >= 0 && cardId2 >= 0) {
-                res.body = ApiControllerAccess::checkCardPair(controller, gameId, cardId1, cardId2, sessionId);
-            } else {
-                res.body = "{\"error\":\"Invalid cardIds\"}";
-            }
+        ::std::string gameId(params.get("id"));
+        ::std::string sessionId(body["sessionId"].asString());
+        
+        ::std::vector<MemoryTrainer::CardMove> moves;
+        if (parseCardMoves(body["moves"], moves)) {
+            res.body = ApiControllerAccess::cardMoves(controller, gameId, moves, sessionId, sinceParam(req));
+        } else {
+            setError(res, "Invalid moves");
         }
-        else if (req.path.find("/api/game/") == 0 && req.path.find("/check") != ::std::string::npos && req.method == "POST") {
-            try {
-                size_t gameIdStart = 10;
-                size_t gameIdEnd = req.path.find("/check");
-                if (gameIdEnd == ::std::string::npos) {
-                    res.statusCode = 400;
-                    res.body = "{\"error\":\"Invalid path\"}";
-                } else {
-                    ::std::string gameId = req.path.substr(gameIdStart, gameIdEnd - gameIdStart);
-                    
-                    ::std::vector<int> answer;
-                    ::std::string sessionId = "";
-                    
-                    
-                    size_t sessionStart = req.body.find("\"sessionId\"");
-                    if (sessionStart != ::std::string::npos) {
-                        size_t colonPos = req.body.find(":", sessionStart);
-                        if (colonPos != ::std::string::npos) {
-                            size_t quoteStart = req.body.find("\"", colonPos);
-                            if (quoteStart != ::std::string::npos) {
-                                size_t quoteEnd = req.body.find("\"", quoteStart + 1);
-                                if (quoteEnd != ::std::string::npos) {
-                                    sessionId = req.body.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                                }
-                            }
-                        }
-                    }
-                    
-                    
-                    
-                    size_t answerStart = req.body.find("\"answer\"");
-                    if (answerStart != ::std::string::npos) {
-                        size_t bracketStart = req.body.find("[", answerStart);
-                        if (bracketStart != ::std::string::npos) {
-                            size_t bracketEnd = req.body.find("]", bracketStart);
-                            if (bracketEnd != ::std::string::npos) {
-                                ::std::string answerStr = req.body.substr(bracketStart + 1, bracketEnd - bracketStart - 1);
-                                
-                                ::std::istringstream iss(answerStr);
-                                ::std::string token;
-                                while (::std::getline(iss, token, ',')) {
-                                    
-                                    token.erase(0, token.find_first_not_of(" \t"));
-                                    token.erase(token.find_last_not_of(" \t") + 1);
-                                    if (!token.empty()) {
-                                        try {
-                                            answer.push_back(::std::stoi(token));
-                                        } catch (...) {
-                                            
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    
-                    res.body = ApiControllerAccess::checkAnswer(controller, gameId, answer, sessionId);
-                }
-            } catch (const ::std::exception& e) {
-                ::std::cerr << "Exception in check handler: " << e.what() << ::std::endl;
-                res.statusCode = 500;
-                res.body = "{\"error\":\"Internal server error\"}";
-            } catch (...) {
-                ::std::cerr << "Unknown exception in check handler" << ::std::endl;
-                res.statusCode = 500;
-                res.body = "{\"error\":\"Internal server error\"}";
-            }
+        return res;
+    });
+    
+    router.get("/api/game/{id}/ws", [&controller](const Request& req, const RouteParams& params) -> Response {
+        Response res;
+        ::std::string gameId(params.get("id"));
+        // Only card games have moves to stream; anything else is refused before the upgrade.
+        auto game = ApiControllerAccess::findGame(controller, gameId);
+        if (!game) {
+            res.statusCode = 404;
+            setError(res, "Game not found");
+            return res;
         }
-        else if (req.path.find("/api/game/") == 0 && req.method == "DELETE") {
-            ::std::string gameId = req.path.substr(10);
-            res.body = ApiControllerAccess::deleteGame(controller, gameId);
+        if (game->getType() != GameType::PAIRS) {
+            res.statusCode = 400;
+            setError(res, "Not a card game");
+            return res;
         }
-        else if (req.path == "/web/leaderboard.html" || req.path == "/leaderboard.html") {
-            ::std::vector<::std::string> paths = {"web/leaderboard.html", "../web/leaderboard.html", "../../web/leaderboard.html"};
-            bool found = false;
-            for (const auto& path : paths) {
-                ::std::ifstream file(path);
-                if (file.is_open()) {
-                    res.statusCode = 200;
-                    res.headers["Content-Type"] = "text/html";
-                    ::std::ostringstream oss;
-                    oss << file.rdbuf();
-                    res.body = oss.str();
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                res.statusCode = 404;
-                res.body = "File not found";
-            }
+        auto channel = ::std::make_shared<CardGameChannel>(controller, gameId, ::std::string(req.query("sessionId")));
+        acceptWebSocket(req, res, channel);
+        return res;
+    });
+    
+    router.post("/api/game/{id}/check", [&controller](const Request& req, const RouteParams& params) -> Response {
+        Response res;
+        SimpleJson::Document body;
+        if (!parseJsonBody(req, body, res)) {
+            return res;
         }
-        else if (req.path == "/" || req.path == "/index.html" || req.path == "/web/index.html") {
-            ::std::vector<::std::string> paths = {"web/index.html", "../web/index.html", "../../web/index.html"};
-            bool found = false;
-            for (const auto& path : paths) {
-                ::std::ifstream file(path);
-                if (file.is_open()) {
-                    res.statusCode = 200;
-                    res.headers["Content-Type"] = "text/html";
-                    ::std::ostringstream oss;
-                    oss << file.rdbuf();
-                    res.body = oss.str();
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                res.statusCode = 404;
-                res.body = "File not found";
+        ::std::string gameId(params.get("id"));
+        ::std::string sessionId(body["sessionId"].asString());
+        
+        SimpleJson::Value answerList = body["answer"];
+        ::std::vector<int> answer;
+        answer.reserve(answerList.size());
+        for (SimpleJson::Value item : answerList) {
+            int value;
+            if (item.getInt(value)) {
+                answer.push_back(value);
             }
         }
-        else if (req.path.find("/web/") == 0) {
-            ::std::string filePath = req.path.substr(1);
-            ::std::vector<::std::string> paths = {filePath, "../" + filePath, "../../" + filePath};
-            bool found = false;
-            for (const auto& path : paths) {
-                ::std::ifstream file(path);
-                if (file.is_open()) {
-                    res.statusCode = 200;
-                    if (req.path.find(".css") != ::std::string::npos) {
-                        res.headers["Content-Type"] = "text/css";
-                    } else if (req.path.find(".js") != ::std::string::npos) {
-                        res.headers["Content-Type"] = "application/javascript";
-                    }
-                    ::std::ostringstream oss;
-                    oss << file.rdbuf();
-                    res.body = oss.str();
-                    found = true;
-                    break;
-                }
+        
+        res.body = ApiControllerAccess::checkAnswer(controller, gameId, answer, sessionId);
+        return res;
+    });
+    
+    router.setFallback([&staticFiles](const Request& req) -> Response {
+        Response res;
+        if (staticFiles.serve(req, res)) {
+            return res;
+        }
+        res.statusCode = 404;
+        if (req.path.find("/web/") == 0) {
+            res.body = "File not found";
+        } else {
+            setError(res, "Not found");
+        }
+        return res;
+    });
+    
+    server.start([&router](const Request& req) -> Response {
+        if (req.method == "OPTIONS") {
+            Response res;
+            res.statusCode = 200;
+            res.headers["Access-Control-Allow-Methods"] = "GET, POST, DELETE, OPTIONS";
+            res.headers["Access-Control-Allow-Headers"] = "Content-Type, Authorization";
+            return res;
+        }
+        SimpleJson::Format format = negotiateFormat(req);
+        SimpleJson::FormatScope scope(format);
+        Response res = router.route(req);
+        if (req.path.compare(0, 5, "/api/") == 0) {
+            // Bodies that are still JSON text get relabelled by the server.
+            if (format == SimpleJson::Format::CBOR && !res.upgrade && !res.headers.count("Content-Type")) {
+                res.headers["Content-Type"] = SimpleJson::contentType(format);
             }
-            if (!found) {
-                res.statusCode = 404;
-                res.body = "File not found";
+            auto vary = res.headers.find("Vary");
+            if (vary == res.headers.end()) {
+                res.headers["Vary"] = "Accept";
+            } else {
+                vary->second = "Accept, " + vary->second;
             }
         }
-        else {
-            res.statusCode = 404;
-            res.body = "{\"error\":\"Not found\"}";
-        }
-        
         return res;
     });
     
     return 0;
 }
-
@@ -22,6 +22,28 @@ int MemoryGame::getMemorizationTime() const {
     }
 }
 
+void MemoryGame::reset(Difficulty difficulty) {
+    difficulty_ = difficulty;
+    sequence_.clear();
+    lastAccessMs_.store(0, ::std::memory_order_relaxed);
+    ::std::lock_guard<::std::mutex> lock(snapshotMutex_);
+    for (auto& snapshot : snapshots_) {
+        snapshot.reset();
+    }
+}
+
+::std::shared_ptr<const GameSnapshot> MemoryGame::getSnapshot(size_t slot) const {
+    ::std::lock_guard<::std::mutex> lock(snapshotMutex_);
+    return slot < kSnapshotSlots ? snapshots_[slot] : nullptr;
+}
+
+void MemoryGame::setSnapshot(size_t slot, ::std::shared_ptr<const GameSnapshot> snapshot) {
+    ::std::lock_guard<::std::mutex> lock(snapshotMutex_);
+    if (slot < kSnapshotSlots) {
+        snapshots_[slot] = ::std::move(snapshot);
+    }
+}
+
 int MemoryGame::getSequenceLength() const {
     switch (difficulty_) {
         case Difficulty::EASY:
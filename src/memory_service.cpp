@@ -1,73 +1,273 @@
 #include "memory_service.h"
 #include "memory_game.h"
 #include "card_pairs_game.h"
-#include <sstream>
-#include <iomanip>
 #include <chrono>
-#include <random>
+#include <algorithm>
+#include <cmath>
 
 namespace MemoryTrainer {
 
+namespace {
+
+int64_t steadyNowMs() {
+    return ::std::chrono::duration_cast<::std::chrono::milliseconds>(
+        ::std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// NUMBERS games are plain sequence games, so they share its pools.
+size_t readyIndex(GameType type, Difficulty difficulty) {
+    return (type == GameType::PAIRS ? 3 : 0) + static_cast<size_t>(difficulty);
+}
+
+}
+
 MemoryService::MemoryService() {
+    idleTtlMs_[static_cast<size_t>(GameType::SEQUENCE)] = 10 * 60 * 1000;
+    idleTtlMs_[static_cast<size_t>(GameType::PAIRS)] = 30 * 60 * 1000;
+    idleTtlMs_[static_cast<size_t>(GameType::NUMBERS)] = 10 * 60 * 1000;
+    for (GameType type : {GameType::SEQUENCE, GameType::PAIRS}) {
+        for (Difficulty difficulty : {Difficulty::EASY, Difficulty::MEDIUM, Difficulty::HARD}) {
+            ReadyPool& pool = readyPools_[readyIndex(type, difficulty)];
+            pool.type = type;
+            pool.difficulty = difficulty;
+        }
+    }
+}
+
+MemoryService::~MemoryService() {
+    stopProducer();
+    stopReaper();
 }
 
-::std::string MemoryService::createGame(GameType type, Difficulty difficulty) {
-    ::std::lock_guard<::std::mutex> lock(gamesMutex_);
+GameId MemoryService::createGame(GameType type, Difficulty difficulty) {
+    auto game = takeReady(type, difficulty);
+    game->touch(steadyNowMs());
     
-    ::std::string gameId = generateGameId();
+    GameId gameId = GameId::generate();
+    games_.insert(gameId, game);
+    created_.fetch_add(1, ::std::memory_order_relaxed);
     
+    return gameId;
+}
+
+::std::shared_ptr<MemoryGame> MemoryService::getGame(const GameId& gameId) {
+    auto game = games_.find(gameId);
+    if (game) {
+        game->touch(steadyNowMs());
+    }
+    return game;
+}
+
+void MemoryService::removeGame(const GameId& gameId) {
+    if (games_.erase(gameId)) {
+        deleted_.fetch_add(1, ::std::memory_order_relaxed);
+    }
+}
+
+void MemoryService::cleanup() {
+    games_.clear();
+}
+
+void MemoryService::setIdleTtl(GameType type, int seconds) {
+    size_t index = static_cast<size_t>(type);
+    if (index < kGameTypes) {
+        idleTtlMs_[index] = static_cast<int64_t>(::std::max(seconds, 0)) * 1000;
+    }
+}
+
+void MemoryService::startReaper(int intervalMs) {
+    if (reaping_.exchange(true)) {
+        return;
+    }
+    reaper_ = ::std::thread([this, intervalMs]() {
+        while (reaping_) {
+            for (int waited = 0; waited < intervalMs && reaping_; waited += 100) {
+                ::std::this_thread::sleep_for(::std::chrono::milliseconds(::std::min(100, intervalMs - waited)));
+            }
+            if (reaping_) {
+                reapExpired();
+            }
+        }
+    });
+}
+
+void MemoryService::stopReaper() {
+    reaping_ = false;
+    if (reaper_.joinable()) {
+        reaper_.join();
+    }
+}
+
+size_t MemoryService::reapExpired() {
+    int64_t now = steadyNowMs();
+    auto expired = [this, now](const GameId&, const MemoryGame& game) {
+        int64_t ttl = idleTtlMs_[static_cast<size_t>(game.getType())];
+        return ttl > 0 && now - game.getLastAccessMs() > ttl;
+    };
+
+    size_t shardCount = games_.shardCount();
+    size_t shardsPerTick = (shardCount + kReapSweepTicks - 1) / kReapSweepTicks;
+    size_t evicted = 0;
+    for (size_t i = 0; i < shardsPerTick; ++i) {
+        size_t shard = reapCursor_;
+        reapCursor_ = (reapCursor_ + 1) % shardCount;
+        size_t batch;
+        do {
+            batch = games_.eraseIf(shard, expired, kReapBatch);
+            evicted += batch;
+        } while (batch == kReapBatch);
+    }
+    expired_.fetch_add(evicted, ::std::memory_order_relaxed);
+    return evicted;
+}
+
+::std::shared_ptr<MemoryGame> MemoryService::newGame(GameType type, Difficulty difficulty) {
     ::std::shared_ptr<MemoryGame> game;
     switch (type) {
         case GameType::SEQUENCE:
-            game = ::std::make_shared<SequenceGame>(difficulty);
+            game = sequencePool_.acquire(difficulty);
             break;
         case GameType::PAIRS:
-            game = ::std::make_shared<CardPairsGame>(difficulty);
+            game = cardPool_.acquire(difficulty);
             break;
         case GameType::NUMBERS:
-            game = ::std::make_shared<SequenceGame>(difficulty);
+            game = sequencePool_.acquire(difficulty);
             break;
     }
-    
     game->generate();
-    games_[gameId] = game;
-    
-    return gameId;
+    return game;
 }
 
-::std::shared_ptr<MemoryGame> MemoryService::getGame(const ::std::string& gameId) {
-    ::std::lock_guard<::std::mutex> lock(gamesMutex_);
-    
-    auto it = games_.find(gameId);
-    if (it != games_.end()) {
-        return it->second;
+::std::shared_ptr<MemoryGame> MemoryService::takeReady(GameType type, Difficulty difficulty) {
+    ReadyPool& pool = readyPools_[readyIndex(type, difficulty)];
+    bool producing = producing_.load(::std::memory_order_relaxed);
+    ::std::shared_ptr<MemoryGame> game;
+    {
+        ::std::lock_guard<::std::mutex> lock(pool.mutex);
+        ++pool.requested;
+        if (!pool.games.empty()) {
+            game = ::std::move(pool.games.back());
+            pool.games.pop_back();
+            ++pool.hits;
+        } else if (producing) {
+            ++pool.misses;
+        }
+        if (producing && pool.games.size() < pool.target && pool.shortSinceMs == 0) {
+            pool.shortSinceMs = steadyNowMs();
+        }
+    }
+    if (producing) {
+        {
+            ::std::lock_guard<::std::mutex> lock(producerMutex_);
+            refillWanted_ = true;
+        }
+        producerCv_.notify_one();
     }
-    return nullptr;
+    return game ? game : newGame(type, difficulty);
 }
 
-void MemoryService::removeGame(const ::std::string& gameId) {
-    ::std::lock_guard<::std::mutex> lock(gamesMutex_);
-    games_.erase(gameId);
+void MemoryService::startProducer(size_t maxReady) {
+    if (maxReady == 0 || producing_.exchange(true)) {
+        return;
+    }
+    maxReady_ = maxReady;
+    producer_ = ::std::thread([this]() {
+        int64_t lastRateMs = steadyNowMs();
+        while (producing_) {
+            int64_t now = steadyNowMs();
+            if (now - lastRateMs >= kRateIntervalMs) {
+                updateReadyTargets(now - lastRateMs);
+                lastRateMs = now;
+            }
+            refillReady();
+            ::std::unique_lock<::std::mutex> lock(producerMutex_);
+            producerCv_.wait_for(lock, ::std::chrono::milliseconds(100),
+                                 [this]() { return refillWanted_ || !producing_; });
+            refillWanted_ = false;
+        }
+    });
 }
 
-void MemoryService::cleanup() {
-    ::std::lock_guard<::std::mutex> lock(gamesMutex_);
-    games_.clear();
+void MemoryService::stopProducer() {
+    {
+        ::std::lock_guard<::std::mutex> lock(producerMutex_);
+        producing_ = false;
+    }
+    producerCv_.notify_one();
+    if (producer_.joinable()) {
+        producer_.join();
+    }
 }
 
-::std::string MemoryService::generateGameId() {
-    auto now = ::std::chrono::system_clock::now();
-    auto time = ::std::chrono::duration_cast<::std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    
-    ::std::random_device rd;
-    ::std::mt19937 gen(rd());
-    ::std::uniform_int_distribution<> dis(1000, 9999);
-    
-    ::std::ostringstream oss;
-    oss << time << "_" << dis(gen);
-    return oss.str();
+void MemoryService::refillReady() {
+    bool shortfall = true;
+    while (shortfall && producing_) {
+        shortfall = false;
+        for (ReadyPool& pool : readyPools_) {
+            {
+                ::std::lock_guard<::std::mutex> lock(pool.mutex);
+                if (pool.games.size() >= pool.target) {
+                    continue;
+                }
+            }
+            auto game = newGame(pool.type, pool.difficulty);
+            ::std::lock_guard<::std::mutex> lock(pool.mutex);
+            pool.games.push_back(::std::move(game));
+            if (pool.games.size() < pool.target) {
+                shortfall = true;
+            } else if (pool.shortSinceMs != 0) {
+                pool.maxLagMs = ::std::max(pool.maxLagMs, steadyNowMs() - pool.shortSinceMs);
+                pool.shortSinceMs = 0;
+            }
+        }
+    }
+}
+
+void MemoryService::updateReadyTargets(int64_t elapsedMs) {
+    for (ReadyPool& pool : readyPools_) {
+        // Games beyond a lowered target go back to the slab pool after the lock.
+        ::std::vector<::std::shared_ptr<MemoryGame>> surplus;
+        ::std::lock_guard<::std::mutex> lock(pool.mutex);
+        double rate = pool.requested * 1000.0 / elapsedMs;
+        pool.requested = 0;
+        pool.rate += (rate - pool.rate) * kRateSmoothing;
+        double wanted = ::std::ceil(pool.rate * kReadySeconds);
+        pool.target = ::std::min(maxReady_, ::std::max<size_t>(1, static_cast<size_t>(wanted)));
+        while (pool.games.size() > pool.target) {
+            surplus.push_back(::std::move(pool.games.back()));
+            pool.games.pop_back();
+        }
+        if (pool.games.size() < pool.target && pool.shortSinceMs == 0) {
+            pool.shortSinceMs = steadyNowMs();
+        }
+    }
 }
 
+GameStats MemoryService::stats() const {
+    GameStats stats;
+    stats.active = games_.size();
+    stats.shards = games_.shardCount();
+    stats.created = created_.load(::std::memory_order_relaxed);
+    stats.deleted = deleted_.load(::std::memory_order_relaxed);
+    stats.expired = expired_.load(::std::memory_order_relaxed);
+    stats.sequencePool = sequencePool_.stats();
+    stats.cardPool = cardPool_.stats();
+    int64_t now = steadyNowMs();
+    for (const ReadyPool& pool : readyPools_) {
+        ::std::lock_guard<::std::mutex> lock(pool.mutex);
+        ReadyPoolStats ready;
+        ready.type = pool.type;
+        ready.difficulty = pool.difficulty;
+        ready.ready = pool.games.size();
+        ready.target = pool.target;
+        ready.createRate = pool.rate;
+        ready.hits = pool.hits;
+        ready.misses = pool.misses;
+        ready.refillLagMs = pool.shortSinceMs != 0 ? now - pool.shortSinceMs : 0;
+        ready.maxRefillLagMs = pool.maxLagMs;
+        stats.ready.push_back(ready);
+    }
+    return stats;
 }
 
+}
@@ -0,0 +1,194 @@
+#include "rate_limiter.h"
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace SimpleHttp {
+
+namespace {
+
+const uint64_t kTokenOne = 1 << 16;
+const uint64_t kMaxTokens = 0xffffffffull;
+
+uint64_t hashKey(size_t classIndex, char kind, ::std::string_view value) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](unsigned char c) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    };
+    mix(static_cast<unsigned char>(classIndex));
+    mix(static_cast<unsigned char>(kind));
+    for (char c : value) {
+        mix(static_cast<unsigned char>(c));
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash == 0 ? 1 : hash;
+}
+
+uint32_t nowMs() {
+    return static_cast<uint32_t>(::std::chrono::duration_cast<::std::chrono::milliseconds>(
+        ::std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}
+
+RateLimiter::RateLimiter(size_t capacity) {
+    size_t perShard = (capacity + kShards - 1) / kShards;
+    setsPerShard_ = (perShard + kWays - 1) / kWays;
+    if (setsPerShard_ == 0) setsPerShard_ = 1;
+    for (auto& shard : shards_) {
+        shard.slots.reset(new Slot[setsPerShard_ * kWays]);
+    }
+}
+
+void RateLimiter::setClass(const ::std::string& name, RateLimit limit) {
+    for (auto& routeClass : classes_) {
+        if (routeClass.name == name) {
+            routeClass.limit = limit;
+            return;
+        }
+    }
+    classes_.push_back({name, limit});
+}
+
+void RateLimiter::assign(const ::std::string& method, const ::std::string& pattern, const ::std::string& className) {
+    for (size_t i = 0; i < classes_.size(); ++i) {
+        if (classes_[i].name == className) {
+            bool prefix = !pattern.empty() && pattern.back() == '*';
+            rules_.push_back({method, prefix ? pattern.substr(0, pattern.size() - 1) : pattern, prefix, i});
+            return;
+        }
+    }
+    throw ::std::invalid_argument("Unknown rate limit class: " + className);
+}
+
+const RateLimiter::RouteClass* RateLimiter::classify(const Request& req) const {
+    for (const auto& rule : rules_) {
+        if (!rule.method.empty() && rule.method != req.method) {
+            continue;
+        }
+        bool matches = rule.prefix ? req.path.substr(0, rule.pattern.size()) == rule.pattern
+                                   : req.path == rule.pattern;
+        if (matches) {
+            return &classes_[rule.classIndex];
+        }
+    }
+    return nullptr;
+}
+
+RateLimiter::Decision RateLimiter::check(const Request& req) {
+    Decision decision;
+    const RouteClass* routeClass = classify(req);
+    if (!routeClass || routeClass->limit.requestsPerSecond <= 0) {
+        return decision;
+    }
+
+    size_t classIndex = routeClass - classes_.data();
+    uint32_t now = nowMs();
+    char address[sizeof(req.remoteAddress)];
+    for (size_t i = 0; i < sizeof(address); ++i) {
+        address[i] = static_cast<char>(req.remoteAddress >> (8 * i));
+    }
+
+    decision.allowed = take(hashKey(classIndex, 'A', ::std::string_view(address, sizeof(address))),
+                            routeClass->limit, now, decision.retryAfterSeconds);
+    if (decision.allowed) {
+        ::std::string_view session = req.query("sessionId");
+        if (session.empty()) session = req.header("X-Session-Id");
+        if (!session.empty()) {
+            decision.allowed = take(hashKey(classIndex, 'S', session), routeClass->limit, now,
+                                    decision.retryAfterSeconds);
+        }
+    }
+
+    if (decision.allowed) {
+        allowed_.fetch_add(1, ::std::memory_order_relaxed);
+    } else {
+        limited_.fetch_add(1, ::std::memory_order_relaxed);
+    }
+    return decision;
+}
+
+// Races between threads can briefly let a recycled bucket or a lost claim through;
+// the limiter errs on the side of allowing rather than taking a lock.
+bool RateLimiter::take(uint64_t key, const RateLimit& limit, uint32_t now, int& retryAfterSeconds) {
+    Shard& shard = shards_[key >> 60];
+    Slot* ways = &shard.slots[(key % setsPerShard_) * kWays];
+
+    double burst = limit.burst < 1 ? 1 : limit.burst;
+    uint64_t capacity = static_cast<uint64_t>(burst * kTokenOne);
+    if (capacity > kMaxTokens) capacity = kMaxTokens;
+
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < kWays; ++i) {
+        if (ways[i].key.load(::std::memory_order_acquire) == key) {
+            slot = &ways[i];
+            break;
+        }
+    }
+
+    if (!slot) {
+        // Take a free way, otherwise the one refilled longest ago.
+        Slot* victim = nullptr;
+        uint64_t victimKey = 0;
+        uint32_t oldestAge = 0;
+        for (size_t i = 0; i < kWays; ++i) {
+            uint64_t current = ways[i].key.load(::std::memory_order_acquire);
+            if (current == 0) {
+                victim = &ways[i];
+                victimKey = 0;
+                break;
+            }
+            uint32_t age = now - static_cast<uint32_t>(ways[i].state.load(::std::memory_order_relaxed) >> 32);
+            if (!victim || age > oldestAge) {
+                victim = &ways[i];
+                victimKey = current;
+                oldestAge = age;
+            }
+        }
+
+        uint64_t expected = victimKey;
+        if (victim->key.compare_exchange_strong(expected, key, ::std::memory_order_acq_rel)) {
+            victim->state.store((static_cast<uint64_t>(now) << 32) | capacity, ::std::memory_order_release);
+            if (victimKey != 0) {
+                evicted_.fetch_add(1, ::std::memory_order_relaxed);
+            }
+        } else if (expected != key) {
+            return true;
+        }
+        slot = victim;
+    }
+
+    const double refillPerMs = limit.requestsPerSecond * kTokenOne / 1000.0;
+    uint64_t old = slot->state.load(::std::memory_order_relaxed);
+    while (true) {
+        uint32_t elapsed = now - static_cast<uint32_t>(old >> 32);
+        if (elapsed > 0x80000000u) elapsed = 0;  // another thread stored a slightly newer time
+        uint64_t tokens = (old & kMaxTokens) + static_cast<uint64_t>(elapsed * refillPerMs);
+        if (tokens > capacity) tokens = capacity;
+
+        bool allowed = tokens >= kTokenOne;
+        uint64_t remaining = allowed ? tokens - kTokenOne : tokens;
+        uint64_t updated = (static_cast<uint64_t>(now) << 32) | remaining;
+        if (slot->state.compare_exchange_weak(old, updated, ::std::memory_order_acq_rel)) {
+            if (!allowed) {
+                retryAfterSeconds = static_cast<int>(::std::ceil((kTokenOne - remaining) / (refillPerMs * 1000.0)));
+                if (retryAfterSeconds < 1) retryAfterSeconds = 1;
+            }
+            return allowed;
+        }
+    }
+}
+
+RateLimiterStats RateLimiter::stats() const {
+    RateLimiterStats result;
+    result.allowed = allowed_.load(::std::memory_order_relaxed);
+    result.limited = limited_.load(::std::memory_order_relaxed);
+    result.evicted = evicted_.load(::std::memory_order_relaxed);
+    result.capacity = kShards * setsPerShard_ * kWays;
+    return result;
+}
+
+}
@@ -0,0 +1,178 @@
+#include "router.h"
+#include <stdexcept>
+
+namespace SimpleHttp {
+
+namespace {
+
+bool isInteger(::std::string_view value) {
+    if (!value.empty() && value.front() == '-') value.remove_prefix(1);
+    if (value.empty() || value.size() > 9) return false;
+    for (char c : value) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
+}
+
+::std::string_view nextSegment(::std::string_view& path) {
+    size_t slash = path.find('/');
+    ::std::string_view segment = path.substr(0, slash);
+    path = slash == ::std::string_view::npos ? ::std::string_view() : path.substr(slash + 1);
+    return segment;
+}
+
+}
+
+::std::string_view RouteParams::get(::std::string_view name) const {
+    for (size_t i = 0; i < count_; ++i) {
+        if (params_[i].name == name) {
+            return params_[i].value;
+        }
+    }
+    return ::std::string_view();
+}
+
+int RouteParams::getInt(::std::string_view name, int fallback) const {
+    ::std::string_view value = get(name);
+    if (!isInteger(value)) {
+        return fallback;
+    }
+    bool negative = value.front() == '-';
+    if (negative) value.remove_prefix(1);
+    int result = 0;
+    for (char c : value) {
+        result = result * 10 + (c - '0');
+    }
+    return negative ? -result : result;
+}
+
+Router::Router() : root_(::std::make_unique<Node>()) {}
+
+Router::~Router() = default;
+
+void Router::add(const ::std::string& method, const ::std::string& pattern, RouteHandler handler) {
+    if (pattern.empty() || pattern.front() != '/') {
+        throw ::std::invalid_argument("Route pattern must start with '/': " + pattern);
+    }
+
+    Node* node = root_.get();
+    ::std::string_view rest = ::std::string_view(pattern).substr(1);
+    while (!rest.empty()) {
+        ::std::string_view segment = nextSegment(rest);
+
+        if (segment.size() > 2 && segment.front() == '{' && segment.back() == '}') {
+            ::std::string_view spec = segment.substr(1, segment.size() - 2);
+            size_t colon = spec.find(':');
+            ::std::string name(spec.substr(0, colon));
+            ParamType type = ParamType::STRING;
+            if (colon != ::std::string_view::npos) {
+                ::std::string_view typeName = spec.substr(colon + 1);
+                if (typeName == "int") {
+                    type = ParamType::INT;
+                } else if (typeName != "string") {
+                    throw ::std::invalid_argument("Unknown route parameter type in " + pattern);
+                }
+            }
+
+            if (!node->param) {
+                node->param = ::std::make_unique<Node>();
+                node->paramName = name;
+                node->paramType = type;
+            } else if (node->paramName != name || node->paramType != type) {
+                throw ::std::invalid_argument("Conflicting route parameter in " + pattern);
+            }
+            node = node->param.get();
+            continue;
+        }
+
+        Node* child = nullptr;
+        for (auto& literal : node->literals) {
+            if (literal.first == segment) {
+                child = literal.second.get();
+                break;
+            }
+        }
+        if (!child) {
+            node->literals.emplace_back(::std::string(segment), ::std::make_unique<Node>());
+            child = node->literals.back().second.get();
+        }
+        node = child;
+    }
+
+    for (auto& existing : node->handlers) {
+        if (existing.first == method) {
+            throw ::std::invalid_argument("Duplicate route: " + method + " " + pattern);
+        }
+    }
+    node->handlers.emplace_back(method, ::std::move(handler));
+}
+
+const Router::Node* Router::match(const Node* node, ::std::string_view path, RouteParams& params) const {
+    if (path.empty()) {
+        return node->handlers.empty() ? nullptr : node;
+    }
+
+    ::std::string_view rest = path;
+    ::std::string_view segment = nextSegment(rest);
+    if (segment.empty()) {
+        return nullptr;
+    }
+
+    for (const auto& literal : node->literals) {
+        if (literal.first == segment) {
+            if (const Node* found = match(literal.second.get(), rest, params)) {
+                return found;
+            }
+            break;
+        }
+    }
+
+    if (node->param && params.count_ < RouteParams::kMaxParams &&
+        (node->paramType != ParamType::INT || isInteger(segment))) {
+        params.params_[params.count_++] = {node->paramName, segment};
+        if (const Node* found = match(node->param.get(), rest, params)) {
+            return found;
+        }
+        --params.count_;
+    }
+    return nullptr;
+}
+
+Response Router::route(const Request& req) const {
+    RouteParams params;
+    ::std::string_view path = req.path;
+    if (!path.empty() && path.front() == '/') {
+        path.remove_prefix(1);
+    }
+
+    const Node* node = match(root_.get(), path, params);
+    if (node) {
+        for (const auto& handler : node->handlers) {
+            if (handler.first == req.method) {
+                return handler.second(req, params);
+            }
+        }
+
+        Response res;
+        res.statusCode = 405;
+        res.body = "{\"error\":\"Method not allowed\"}";
+        ::std::string allow;
+        for (const auto& handler : node->handlers) {
+            if (!allow.empty()) allow += ", ";
+            allow += handler.first;
+        }
+        res.headers["Allow"] = allow;
+        return res;
+    }
+
+    if (fallback_) {
+        return fallback_(req);
+    }
+
+    Response res;
+    res.statusCode = 404;
+    res.body = "{\"error\":\"Not found\"}";
+    return res;
+}
+
+}
@@ -0,0 +1,237 @@
+#include "static_files.h"
+#include "compression.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace SimpleHttp {
+
+namespace {
+
+const size_t kMinGzipSize = 256;
+const int kStaticGzipLevel = 9;
+
+const char* contentTypeFor(const ::std::string& path) {
+    static const ::std::pair<const char*, const char*> types[] = {
+        {".html", "text/html"},
+        {".css", "text/css"},
+        {".js", "application/javascript"},
+        {".json", "application/json"},
+        {".svg", "image/svg+xml"},
+        {".png", "image/png"},
+        {".jpg", "image/jpeg"},
+        {".ico", "image/x-icon"},
+        {".txt", "text/plain"},
+    };
+    for (const auto& type : types) {
+        size_t extLen = ::std::char_traits<char>::length(type.first);
+        if (path.size() >= extLen && path.compare(path.size() - extLen, extLen, type.first) == 0) {
+            return type.second;
+        }
+    }
+    return "application/octet-stream";
+}
+
+::std::string makeEtag(const ::std::string& content) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char buf[48];
+    ::std::snprintf(buf, sizeof(buf), "\"%zx-%016llx\"", content.size(), static_cast<unsigned long long>(hash));
+    return buf;
+}
+
+::std::string httpDate(::std::time_t t) {
+    struct tm tmBuf;
+    gmtime_r(&t, &tmBuf);
+    char buf[64];
+    ::std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tmBuf);
+    return buf;
+}
+
+}
+
+StaticFile::~StaticFile() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+StaticFileCache::StaticFileCache(const ::std::string& root, size_t sendfileThreshold)
+    : root_(root), sendfileThreshold_(sendfileThreshold), index_(::std::make_shared<Index>()) {
+    reload();
+}
+
+StaticFileCache::~StaticFileCache() {
+    watching_ = false;
+    if (watcher_.joinable()) {
+        watcher_.join();
+    }
+}
+
+::std::string StaticFileCache::resolveRoot(const ::std::vector<::std::string>& candidates) {
+    ::std::error_code ec;
+    for (const auto& candidate : candidates) {
+        if (::std::filesystem::is_directory(candidate, ec)) {
+            return ::std::filesystem::canonical(candidate, ec).string();
+        }
+    }
+    return candidates.empty() ? "" : candidates.front();
+}
+
+void StaticFileCache::alias(const ::std::string& urlPath, const ::std::string& target) {
+    aliases_[urlPath] = target;
+}
+
+void StaticFileCache::reload() {
+    auto previous = snapshot();
+    auto index = ::std::make_shared<Index>();
+
+    ::std::error_code ec;
+    ::std::filesystem::recursive_directory_iterator it(root_, ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+
+        ::std::string filePath = it->path().string();
+        ::std::string urlPath = "/web/" + ::std::filesystem::relative(it->path(), root_, ec).generic_string();
+
+        auto prevIt = previous->find(urlPath);
+        auto file = loadFile(filePath, prevIt != previous->end() ? prevIt->second : nullptr);
+        if (file) {
+            (*index)[urlPath] = file;
+        }
+    }
+
+    ::std::lock_guard<::std::mutex> lock(indexMutex_);
+    index_ = index;
+}
+
+void StaticFileCache::watch(int intervalMs) {
+    if (watching_.exchange(true)) {
+        return;
+    }
+    watcher_ = ::std::thread([this, intervalMs]() {
+        while (watching_) {
+            for (int waited = 0; waited < intervalMs && watching_; waited += 100) {
+                ::std::this_thread::sleep_for(::std::chrono::milliseconds(100));
+            }
+            if (watching_) {
+                reload();
+            }
+        }
+    });
+}
+
+::std::shared_ptr<const StaticFile> StaticFileCache::loadFile(const ::std::string& filePath,
+                                                              const ::std::shared_ptr<const StaticFile>& previous) const {
+    struct stat st;
+    if (stat(filePath.c_str(), &st) != 0) {
+        return nullptr;
+    }
+    if (previous && previous->mtime == st.st_mtime && previous->size == static_cast<size_t>(st.st_size)) {
+        return previous;
+    }
+
+    ::std::ifstream in(filePath, ::std::ios::binary);
+    if (!in.is_open()) {
+        return nullptr;
+    }
+    ::std::ostringstream oss;
+    oss << in.rdbuf();
+
+    auto file = ::std::make_shared<StaticFile>();
+    file->filePath = filePath;
+    file->contentType = contentTypeFor(filePath);
+    file->content = oss.str();
+    file->size = file->content.size();
+    file->etag = makeEtag(file->content);
+    file->mtime = st.st_mtime;
+    file->lastModified = httpDate(st.st_mtime);
+
+    if (file->size >= kMinGzipSize && isCompressibleType(file->contentType)) {
+        ::std::string gz = gzipCompress(file->content, kStaticGzipLevel);
+        if (!gz.empty() && gz.size() < file->size) {
+            file->gzipContent = ::std::move(gz);
+            file->gzipEtag = file->etag.substr(0, file->etag.size() - 1) + "-gz\"";
+        }
+    }
+
+    if (file->size > sendfileThreshold_) {
+        file->fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file->fd >= 0) {
+            ::std::string().swap(file->content);
+        }
+    }
+    return file;
+}
+
+::std::shared_ptr<const StaticFileCache::Index> StaticFileCache::snapshot() const {
+    ::std::lock_guard<::std::mutex> lock(indexMutex_);
+    return index_;
+}
+
+::std::shared_ptr<const StaticFile> StaticFileCache::find(const ::std::string& urlPath) const {
+    auto aliasIt = aliases_.find(urlPath);
+    const ::std::string& key = aliasIt != aliases_.end() ? aliasIt->second : urlPath;
+
+    auto index = snapshot();
+    auto it = index->find(key);
+    return it != index->end() ? it->second : nullptr;
+}
+
+size_t StaticFileCache::fileCount() const {
+    return snapshot()->size();
+}
+
+bool StaticFileCache::serve(const Request& req, Response& res) const {
+    auto file = find(::std::string(req.path));
+    if (!file) {
+        return false;
+    }
+
+    bool gzip = !file->gzipContent.empty() && acceptsGzip(req);
+    const ::std::string& etag = gzip ? file->gzipEtag : file->etag;
+
+    res.headers["ETag"] = etag;
+    res.headers["Last-Modified"] = file->lastModified;
+    res.headers["Cache-Control"] = "no-cache";
+    if (!file->gzipContent.empty()) {
+        res.headers["Vary"] = "Accept-Encoding";
+    }
+
+    bool notModified = req.hasHeader("If-None-Match")
+        ? etagMatches(req.header("If-None-Match"), etag)
+        : (req.hasHeader("If-Modified-Since") && req.header("If-Modified-Since") == file->lastModified);
+
+    if (notModified) {
+        res.statusCode = 304;
+        res.body.clear();
+        return true;
+    }
+
+    res.statusCode = 200;
+    res.headers["Content-Type"] = file->contentType;
+    if (gzip) {
+        res.headers["Content-Encoding"] = "gzip";
+        res.shared = {file->gzipContent, file};
+    } else if (file->fd >= 0) {
+        res.file.fd = file->fd;
+        res.file.size = file->size;
+        res.file.owner = file;
+    } else {
+        res.shared = {file->content, file};
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,91 @@
+#include "timer_wheel.h"
+
+namespace SimpleHttp {
+
+TimerWheel::TimerWheel(uint64_t nowMs, unsigned tickMs)
+    : currentTick_(nowMs / tickMs), tickMs_(tickMs) {
+    for (auto& level : slots_) {
+        for (auto& head : level) {
+            head.prev = head.next = &head;
+        }
+    }
+}
+
+void TimerWheel::schedule(TimerNode& node, uint64_t deadlineMs) {
+    if (node.scheduled()) {
+        unlink(node);
+        --size_;
+    }
+
+    uint64_t tick = (deadlineMs + tickMs_ - 1) / tickMs_;
+    uint64_t maxTick = currentTick_ + (static_cast<uint64_t>(1) << (kSlotBits * kLevels)) - 1;
+    node.expiresTick = tick <= currentTick_ ? currentTick_ + 1 : (tick > maxTick ? maxTick : tick);
+    insert(node);
+    ++size_;
+}
+
+void TimerWheel::cancel(TimerNode& node) {
+    if (node.scheduled()) {
+        unlink(node);
+        --size_;
+    }
+}
+
+void TimerWheel::advance(uint64_t nowMs, ::std::vector<TimerNode*>& expired) {
+    uint64_t target = nowMs / tickMs_;
+    if (size_ == 0) {
+        if (target > currentTick_) currentTick_ = target;
+        return;
+    }
+
+    while (currentTick_ < target && size_ > 0) {
+        ++currentTick_;
+
+        // When a level wraps, spread the matching slot of the next level over the finer ones.
+        for (unsigned level = 1; level < kLevels; ++level) {
+            uint64_t mask = (static_cast<uint64_t>(1) << (kSlotBits * level)) - 1;
+            if ((currentTick_ & mask) != 0) {
+                break;
+            }
+            TimerNode& head = slots_[level][(currentTick_ >> (kSlotBits * level)) & (kSlots - 1)];
+            while (head.next != &head) {
+                TimerNode* node = head.next;
+                unlink(*node);
+                insert(*node);
+            }
+        }
+
+        TimerNode& head = slots_[0][currentTick_ & (kSlots - 1)];
+        while (head.next != &head) {
+            TimerNode* node = head.next;
+            unlink(*node);
+            --size_;
+            expired.push_back(node);
+        }
+    }
+    if (currentTick_ < target) {
+        currentTick_ = target;
+    }
+}
+
+void TimerWheel::insert(TimerNode& node) {
+    uint64_t delta = node.expiresTick > currentTick_ ? node.expiresTick - currentTick_ : 0;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (static_cast<uint64_t>(1) << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+
+    TimerNode& head = slots_[level][(node.expiresTick >> (kSlotBits * level)) & (kSlots - 1)];
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+}
+
+void TimerWheel::unlink(TimerNode& node) {
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.prev = node.next = nullptr;
+}
+
+}
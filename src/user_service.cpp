@@ -4,7 +4,6 @@
 #include <iomanip>
 #include <algorithm>
 #include <chrono>
-#include <random>
 #include <cstring>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
@@ -19,19 +18,19 @@ UserService::~UserService() {
     saveUsers();
 }
 
-::std::string UserService::registerUser(const ::std::string& username, const ::std::string& email, const ::std::string& password) {
+UserId UserService::registerUser(const ::std::string& username, const ::std::string& email, const ::std::string& password) {
     ::std::lock_guard<::std::mutex> lock(usersMutex_);
     
     for (const auto& [id, user] : users_) {
         if (user->username == username) {
-            return "";
+            return UserId();
         }
         if (user->email == email) {
-            return "";
+            return UserId();
         }
     }
     
-    ::std::string userId = generateUserId();
+    UserId userId = UserId::generate();
     ::std::string passwordHash = hashPassword(password);
     
     auto user = ::std::make_shared<User>(username, email, passwordHash);
@@ -43,37 +42,37 @@ UserService::~UserService() {
     return userId;
 }
 
-::std::string UserService::loginUser(const ::std::string& username, const ::std::string& password) {
+SessionId UserService::loginUser(const ::std::string& username, const ::std::string& password) {
     ::std::lock_guard<::std::mutex> lock(usersMutex_);
     
     for (const auto& [id, user] : users_) {
         if (user->username == username) {
             if (verifyPassword(password, user->passwordHash)) {
-                ::std::string sessionId = generateSessionId();
+                SessionId sessionId = SessionId::generate();
                 sessions_[sessionId] = user->id;
                 user->lastLogin = ::std::chrono::system_clock::now();
                 saveUsers();
                 return sessionId;
             }
-            return "";
+            return SessionId();
         }
     }
     
-    return "";
+    return SessionId();
 }
 
-bool UserService::logoutUser(const ::std::string& sessionId) {
+bool UserService::logoutUser(const SessionId& sessionId) {
     ::std::lock_guard<::std::mutex> lock(usersMutex_);
     return sessions_.erase(sessionId) > 0;
 }
 
-::std::shared_ptr<User> UserService::getUserById(const ::std::string& userId) {
+::std::shared_ptr<User> UserService::getUserById(const UserId& userId) {
     ::std::lock_guard<::std::mutex> lock(usersMutex_);
     auto it = users_.find(userId);
     return (it != users_.end()) ? it->second : nullptr;
 }
 
-::std::shared_ptr<User> UserService::getUserBySession(const ::std::string& sessionId) {
+::std::shared_ptr<User> UserService::getUserBySession(const SessionId& sessionId) {
     ::std::lock_guard<::std::mutex> lock(usersMutex_);
     auto it = sessions_.find(sessionId);
     if (it != sessions_.end()) {
@@ -94,7 +93,7 @@ bool UserService::logoutUser(const ::std::string& sessionId) {
     return nullptr;
 }
 
-void UserService::updateUserStats(const ::std::string& userId, int score, bool won) {
+void UserService::updateUserStats(const UserId& userId, int score, bool won) {
     ::std::lock_guard<::std::mutex> lock(usersMutex_);
     
     auto userIt = users_.find(userId);
@@ -146,7 +145,7 @@ void UserService::saveUsers() {
     if (!file.is_open()) return;
     
     for (const auto& [id, user] : users_) {
-        file << user->id << "\n";
+        file << user->id.toString() << "\n";
         file << user->username << "\n";
         file << user->email << "\n";
         file << user->passwordHash << "\n";
@@ -167,12 +166,18 @@ void UserService::loadUsers() {
     ::std::ifstream file(dataFile_);
     if (!file.is_open()) return;
     
+    bool migrated = false;
     ::std::string line;
     while (::std::getline(file, line)) {
         if (line == "---") continue;
         
         auto user = ::std::make_shared<User>();
-        user->id = line;
+        // Files written before binary IDs hold "user_<time>_<n>"; those users
+        // get a new ID and the file is rewritten once loaded.
+        if (!UserId::parse(line, user->id)) {
+            user->id = UserId::generate();
+            migrated = true;
+        }
         
         ::std::getline(file, user->username);
         ::std::getline(file, user->email);
@@ -201,34 +206,11 @@ void UserService::loadUsers() {
         
         ::std::getline(file, line);
     }
-}
-
-::std::string UserService::generateUserId() {
-    static ::std::random_device rd;
-    static ::std::mt19937 gen(rd());
-    static ::std::uniform_int_distribution<> dis(100000, 999999);
-    
-    auto now = ::std::chrono::system_clock::now();
-    auto time = ::std::chrono::duration_cast<::std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    
-    ::std::ostringstream oss;
-    oss << "user_" << time << "_" << dis(gen);
-    return oss.str();
-}
-
-::std::string UserService::generateSessionId() {
-    static ::std::random_device rd;
-    static ::std::mt19937 gen(rd());
-    static ::std::uniform_int_distribution<> dis(100000, 999999);
     
-    auto now = ::std::chrono::system_clock::now();
-    auto time = ::std::chrono::duration_cast<::std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    
-    ::std::ostringstream oss;
-    oss << "session_" << time << "_" << dis(gen);
-    return oss.str();
+    if (migrated) {
+        file.close();
+        saveUsers();
+    }
 }
 
 ::std::string UserService::hashPassword(const ::std::string& password) {
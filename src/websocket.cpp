@@ -0,0 +1,161 @@
+#include "websocket.h"
+#include "http_parser.h"
+#include <openssl/evp.h>
+
+namespace SimpleHttp {
+
+namespace {
+
+const char* const kHandshakeGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+const size_t kMaxControlPayload = 125;
+
+::std::string base64Encode(const unsigned char* data, size_t size) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    ::std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < size) chunk |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < size) chunk |= data[i + 2];
+        out += kAlphabet[(chunk >> 18) & 63];
+        out += kAlphabet[(chunk >> 12) & 63];
+        out += i + 1 < size ? kAlphabet[(chunk >> 6) & 63] : '=';
+        out += i + 2 < size ? kAlphabet[chunk & 63] : '=';
+    }
+    return out;
+}
+
+::std::string acceptKey(::std::string_view key) {
+    ::std::string input(key);
+    input += kHandshakeGuid;
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLen = 0;
+    EVP_Digest(input.data(), input.size(), digest, &digestLen, EVP_sha1(), nullptr);
+    return base64Encode(digest, digestLen);
+}
+
+// True if the comma-separated header value lists token (case-insensitive).
+bool hasToken(::std::string_view value, ::std::string_view token) {
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        ::std::string_view item = value.substr(0, comma);
+        value = comma == ::std::string_view::npos ? ::std::string_view() : value.substr(comma + 1);
+
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (equalsIgnoreCase(item, token)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+bool acceptWebSocket(const Request& req, Response& res, ::std::shared_ptr<WebSocketHandler> handler) {
+    ::std::string_view key = req.header("Sec-WebSocket-Key");
+    if (req.method != "GET" || !hasToken(req.header("Upgrade"), "websocket") ||
+        !hasToken(req.header("Connection"), "upgrade") || key.size() != 24) {
+        res.statusCode = 400;
+        res.body = "{\"error\":\"WebSocket upgrade required\"}";
+        return false;
+    }
+    if (req.header("Sec-WebSocket-Version") != "13") {
+        res.statusCode = 426;
+        res.body = "{\"error\":\"Unsupported WebSocket version\"}";
+        res.headers["Sec-WebSocket-Version"] = "13";
+        return false;
+    }
+
+    res.statusCode = 101;
+    res.body.clear();
+    res.headers["Upgrade"] = "websocket";
+    res.headers["Connection"] = "Upgrade";
+    res.headers["Sec-WebSocket-Accept"] = acceptKey(key);
+    res.upgrade = ::std::move(handler);
+    return true;
+}
+
+WebSocketFrameParser::Status WebSocketFrameParser::parse(char* data, size_t size, WebSocketFrame& frame) {
+    frameSize_ = 0;
+    if (size < 2) {
+        return Status::INCOMPLETE;
+    }
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    bool fin = bytes[0] & 0x80;
+    uint8_t opcode = bytes[0] & 0x0F;
+    bool masked = bytes[1] & 0x80;
+    uint64_t length = bytes[1] & 0x7F;
+
+    bool control = opcode & 0x8;
+    bool knownOpcode = opcode <= 0x2 || (opcode >= 0x8 && opcode <= 0xA);
+    if ((bytes[0] & 0x70) || !knownOpcode || !masked || (control && (!fin || length > kMaxControlPayload))) {
+        return Status::PROTOCOL_ERROR;
+    }
+
+    size_t headerSize = 2;
+    if (length == 126) {
+        headerSize += 2;
+    } else if (length == 127) {
+        headerSize += 8;
+    }
+    if (size < headerSize + 4) {
+        return Status::INCOMPLETE;
+    }
+    if (length >= 126) {
+        length = 0;
+        for (size_t i = 2; i < headerSize; ++i) {
+            length = (length << 8) | bytes[i];
+        }
+    }
+    if (length > maxPayload_) {
+        return Status::TOO_LARGE;
+    }
+
+    const unsigned char* mask = bytes + headerSize;
+    headerSize += 4;
+    if (size - headerSize < length) {
+        return Status::INCOMPLETE;
+    }
+
+    char* payload = data + headerSize;
+    for (size_t i = 0; i < length; ++i) {
+        payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+    }
+
+    frame.opcode = static_cast<WebSocketOpcode>(opcode);
+    frame.fin = fin;
+    frame.payload = payload;
+    frame.payloadSize = static_cast<size_t>(length);
+    frameSize_ = headerSize + static_cast<size_t>(length);
+    return Status::COMPLETE;
+}
+
+::std::string webSocketFrameHeader(WebSocketOpcode opcode, size_t payloadSize) {
+    ::std::string header;
+    header += static_cast<char>(0x80 | static_cast<uint8_t>(opcode));
+    if (payloadSize < 126) {
+        header += static_cast<char>(payloadSize);
+    } else if (payloadSize <= 0xFFFF) {
+        header += static_cast<char>(126);
+        header += static_cast<char>(payloadSize >> 8);
+        header += static_cast<char>(payloadSize);
+    } else {
+        header += static_cast<char>(127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            header += static_cast<char>(static_cast<uint64_t>(payloadSize) >> shift);
+        }
+    }
+    return header;
+}
+
+::std::string webSocketClosePayload(uint16_t statusCode) {
+    ::std::string payload;
+    payload += static_cast<char>(statusCode >> 8);
+    payload += static_cast<char>(statusCode);
+    return payload;
+}
+
+}
@@ -9,8 +9,89 @@ let gameTimer = null;
 let startTime = null;
 let flippedCards = [];
 let checkPairTimeout = null;
+let gameSocket = null;
 let sessionId = localStorage.getItem('sessionId') || '';
 
+// Игровые эндпоинты отвечают компактным CBOR (RFC 8949), если его попросить
+const API_ACCEPT = 'application/cbor, application/json;q=0.9';
+
+function decodeCbor(buffer) {
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    const utf8 = new TextDecoder();
+    const BREAK = Symbol('break');
+    let offset = 0;
+
+    function readArgument(info) {
+        if (info < 24) return info;
+        let value;
+        if (info === 24) { value = view.getUint8(offset); offset += 1; }
+        else if (info === 25) { value = view.getUint16(offset); offset += 2; }
+        else if (info === 26) { value = view.getUint32(offset); offset += 4; }
+        else if (info === 27) { value = Number(view.getBigUint64(offset)); offset += 8; }
+        else throw new Error('Unsupported CBOR length');
+        return value;
+    }
+
+    function readItem() {
+        const initial = view.getUint8(offset++);
+        const major = initial >> 5;
+        const info = initial & 0x1f;
+        if (initial === 0xff) return BREAK;
+
+        if (major === 7) {
+            switch (info) {
+                case 20: return false;
+                case 21: return true;
+                case 22: case 23: return null;
+                case 26: offset += 4; return view.getFloat32(offset - 4);
+                case 27: offset += 8; return view.getFloat64(offset - 8);
+                default: throw new Error('Unsupported CBOR simple value');
+            }
+        }
+        if (info === 31 && (major === 4 || major === 5)) {
+            const result = major === 4 ? [] : {};
+            for (;;) {
+                const item = readItem();
+                if (item === BREAK) return result;
+                if (major === 4) result.push(item);
+                else result[item] = readItem();
+            }
+        }
+
+        const argument = readArgument(info);
+        switch (major) {
+            case 0: return argument;
+            case 1: return -1 - argument;
+            case 2: case 3: {
+                const chunk = bytes.subarray(offset, offset + argument);
+                offset += argument;
+                return major === 3 ? utf8.decode(chunk) : chunk;
+            }
+            case 4: return Array.from({ length: argument }, () => readItem());
+            case 5: {
+                const result = {};
+                for (let i = 0; i < argument; i++) {
+                    const key = readItem();
+                    result[key] = readItem();
+                }
+                return result;
+            }
+            default: return readItem();   // тег: берём само значение
+        }
+    }
+
+    return readItem();
+}
+
+async function readApiResponse(response) {
+    const type = response.headers.get('Content-Type') || '';
+    if (type.startsWith('application/cbor')) {
+        return decodeCbor(await response.arrayBuffer());
+    }
+    return response.json();
+}
+
 async function startGame() {
     console.log('startGame called');
     const gameType = document.getElementById('gameType').value;
@@ -21,26 +102,15 @@ async function startGame() {
     try {
         const url = `/api/game?type=${gameType}&difficulty=${difficulty}`;
         console.log('Fetching:', url);
-        const response = await fetch(url, { method: 'POST' });
+        const response = await fetch(url, { method: 'POST', headers: { 'Accept': API_ACCEPT } });
         console.log('Response status:', response.status);
         
         if (!response.ok) {
             throw new Error(`HTTP error! status: ${response.status}`);
         }
         
-        const responseText = await response.text();
-        console.log('Response text (first 100 chars):', responseText.substring(0, 100));
-        console.log('Response text (full):', responseText);
-        
-        let data;
-        try {
-            data = JSON.parse(responseText);
-            console.log('Response data:', data);
-        } catch (parseError) {
-            console.error('JSON Parse Error:', parseError);
-            console.error('Problematic JSON:', responseText);
-            throw parseError;
-        }
+        const data = await readApiResponse(response);
+        console.log('Response data:', data);
         
         if (data.error) {
             alert('Ошибка: ' + data.error);
@@ -89,6 +159,82 @@ function startCardGame(data) {
     document.getElementById('moves').textContent = '0';
     document.getElementById('pairsFound').textContent = '0';
     flippedCards = [];
+    openGameSocket();
+}
+
+// Ходы карточной игры идут через WebSocket; пока он не открыт, используется REST
+function openGameSocket() {
+    closeGameSocket();
+    if (!window.WebSocket) return;
+    
+    const protocol = location.protocol === 'https:' ? 'wss:' : 'ws:';
+    const socket = new WebSocket(`${protocol}//${location.host}/api/game/${currentGameId}/ws?sessionId=${encodeURIComponent(sessionId)}`);
+    socket.onmessage = (event) => handleSocketMessage(JSON.parse(event.data));
+    socket.onclose = () => {
+        if (gameSocket === socket) gameSocket = null;
+    };
+    gameSocket = socket;
+}
+
+function closeGameSocket() {
+    if (gameSocket) {
+        const socket = gameSocket;
+        gameSocket = null;
+        socket.close();
+    }
+}
+
+function socketReady() {
+    return gameSocket && gameSocket.readyState === WebSocket.OPEN;
+}
+
+function cardElement(cardId) {
+    return document.querySelector(`#cardsGrid .card[data-card-id="${cardId}"]`);
+}
+
+function handleSocketMessage(data) {
+    if (data.type === 'error') {
+        console.error('Ошибка:', data.error);
+        return;
+    }
+    
+    if (data.type === 'flip') {
+        const cardDiv = cardElement(data.cardId);
+        if (cardDiv) cardDiv.classList.add('flipped');
+        flippedCards = data.flippedCards.map(id => parseInt(id));
+        
+        if (flippedCards.length === 2) {
+            if (checkPairTimeout) clearTimeout(checkPairTimeout);
+            checkPairTimeout = setTimeout(() => {
+                checkCardPair(flippedCards[0], flippedCards[1]);
+            }, 1000);
+        }
+        return;
+    }
+    
+    if (data.type === 'pair') {
+        const isPair = data.isPair === 'true' || data.isPair === true;
+        [data.cardId1, data.cardId2].forEach(id => {
+            const cardDiv = cardElement(id);
+            if (!cardDiv) return;
+            if (isPair) {
+                cardDiv.classList.add('matched');
+                cardDiv.onclick = null;
+            } else {
+                cardDiv.classList.remove('flipped');
+            }
+        });
+        flippedCards = [];
+        document.getElementById('moves').textContent = data.moves;
+        document.getElementById('pairsFound').textContent = data.pairsFound;
+        
+        if (data.isComplete === 'true' || data.isComplete === true) {
+            showResult(true, data.message, parseInt(data.score || 0));
+            if (sessionId) {
+                setTimeout(() => updateUserInfo(), 500);
+            }
+        }
+    }
 }
 
 function renderCards(cards) {
@@ -133,15 +279,20 @@ async function flipCard(cardId) {
     if (flippedCards.length >= 2) return;
     if (flippedCards.includes(cardId)) return;
     
+    if (socketReady()) {
+        gameSocket.send(JSON.stringify({ type: 'flip', cardId }));
+        return;
+    }
+    
     try {
         const url = `/api/game/${currentGameId}/flip`;
         const response = await fetch(url, {
             method: 'POST',
-            headers: { 'Content-Type': 'application/json' },
+            headers: { 'Content-Type': 'application/json', 'Accept': API_ACCEPT },
             body: JSON.stringify({ cardId })
         });
         
-        const data = await response.json();
+        const data = await readApiResponse(response);
         
         if (data.error) {
             alert('Ошибка: ' + data.error);
@@ -171,15 +322,20 @@ async function flipCard(cardId) {
 }
 
 async function checkCardPair(cardId1, cardId2) {
+    if (socketReady()) {
+        gameSocket.send(JSON.stringify({ type: 'check-pair', cardId1, cardId2 }));
+        return;
+    }
+    
     try {
         const url = `/api/game/${currentGameId}/check-pair`;
         const response = await fetch(url, {
             method: 'POST',
-            headers: { 'Content-Type': 'application/json' },
+            headers: { 'Content-Type': 'application/json', 'Accept': API_ACCEPT },
             body: JSON.stringify({ cardId1, cardId2, sessionId })
         });
         
-        const data = await response.json();
+        const data = await readApiResponse(response);
         
         if (data.error) {
             alert('Ошибка: ' + data.error);
@@ -314,11 +470,11 @@ async function checkAnswer() {
         const url = `/api/game/${currentGameId}/check`;
         const response = await fetch(url, {
             method: 'POST',
-            headers: { 'Content-Type': 'application/json' },
+            headers: { 'Content-Type': 'application/json', 'Accept': API_ACCEPT },
             body: JSON.stringify({ answer: currentAnswer, sessionId })
         });
         
-        const data = await response.json();
+        const data = await readApiResponse(response);
         
         if (data.error) {
             alert('Ошибка: ' + data.error);
@@ -365,6 +521,7 @@ function resetGame() {
     if (memorizationTimer) clearInterval(memorizationTimer);
     if (gameTimer) clearInterval(gameTimer);
     if (checkPairTimeout) clearTimeout(checkPairTimeout);
+    closeGameSocket();
     
     currentGameId = null;
     currentGameType = null;